@@ -0,0 +1,159 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+/*
+ * Measures loading a button map folder with 1, 2, 4 and 8 workers. Each run
+ * indexes a new XML database, which reads the device record of every button
+ * map file, and then loads every button map, as is done before a controller
+ * profile is derived. The files are in the page cache after the first run.
+ *
+ * Usage: buttonmap_load_bench [button map folder]
+ *
+ * The folder defaults to the button maps shipped with the add-on.
+ */
+
+#include "filesystem/Filesystem.h"
+#include "log/Log.h"
+#include "storage/Device.h"
+#include "storage/IDatabase.h"
+#include "storage/StorageDefinitions.h"
+#include "storage/StorageManager.h"
+#include "storage/xml/DatabaseXml.h"
+
+#include <kodi/Filesystem.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+using namespace JOYSTICK;
+
+namespace
+{
+  const unsigned int WARMUP_RUNS = 2;
+  const unsigned int RUNS        = 20;
+
+  const unsigned int WORKER_COUNTS[] = { 1, 2, 4, 8 };
+
+  class CBenchmarkCallbacks : public IDatabaseCallbacks
+  {
+  public:
+    virtual void OnAdd(const DevicePtr& driverInfo, const ButtonMap& buttonMap) override { m_buttonMapCount++; }
+    virtual DevicePtr CreateDevice(const CDevice& deviceInfo) override { return std::make_shared<CDevice>(deviceInfo); }
+
+    unsigned int ButtonMapCount(void) const { return m_buttonMapCount; }
+
+  private:
+    unsigned int m_buttonMapCount = 0;
+  };
+
+  class CBenchmarkControllerHelper : public IControllerHelper
+  {
+  public:
+    virtual JOYSTICK_FEATURE_TYPE FeatureType(const std::string& strControllerId, const std::string &featureName) override
+    {
+      return JOYSTICK_FEATURE_TYPE_UNKNOWN;
+    }
+  };
+
+  /*!
+   * \brief Count the button map files in a folder and its provider folders
+   */
+  unsigned int CountFiles(const std::string& path, unsigned int folderDepth)
+  {
+    unsigned int count = 0;
+
+    std::vector<kodi::vfs::CDirEntry> items;
+    kodi::vfs::GetDirectory(path, RESOURCE_XML_EXTENSION "|", items);
+
+    for (const kodi::vfs::CDirEntry& item : items)
+    {
+      if (!item.IsFolder())
+        count++;
+      else if (folderDepth > 0)
+        count += CountFiles(item.Path(), folderDepth - 1);
+    }
+
+    return count;
+  }
+
+  /*!
+   * \brief Index a new database and load all of its button maps, in
+   *        milliseconds
+   *
+   * \param buttonMapCount The number of button maps that were loaded
+   */
+  double Load(const std::string& path, unsigned int workerCount, unsigned int& buttonMapCount)
+  {
+    CBenchmarkCallbacks callbacks;
+    CBenchmarkControllerHelper controllerHelper;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    CDatabaseXml database(path, false, &callbacks, &controllerHelper);
+    database.SetWorkerCount(workerCount);
+    database.UpdateIndex();
+    database.ReportButtonMaps();
+
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    buttonMapCount = callbacks.ButtonMapCount();
+
+    return std::chrono::duration<double, std::milli>(elapsed).count();
+  }
+}
+
+int main(int argc, char** argv)
+{
+  CLog::Get().SetLevel(SYS_LOG_ERROR);
+
+  const std::string path = (argc > 1 ? argv[1] : BUTTONMAP_PATH);
+
+  if (!CFilesystem::Initialize())
+    return EXIT_FAILURE;
+
+  // The database indexes the "xml" subfolder
+  const unsigned int fileCount = CountFiles(path + "/" RESOURCE_XML_FOLDER, 1);
+  if (fileCount == 0)
+  {
+    fprintf(stderr, "No button maps found in %s/%s\n", path.c_str(), RESOURCE_XML_FOLDER);
+    return EXIT_FAILURE;
+  }
+
+  printf("Loading %u button maps in %s\n", fileCount, path.c_str());
+
+  double baselineMs = 0.0;
+  unsigned int buttonMapCount = 0;
+
+  for (unsigned int workerCount : WORKER_COUNTS)
+  {
+    for (unsigned int run = 0; run < WARMUP_RUNS; run++)
+      Load(path, workerCount, buttonMapCount);
+
+    std::vector<double> times;
+    for (unsigned int run = 0; run < RUNS; run++)
+      times.push_back(Load(path, workerCount, buttonMapCount));
+
+    std::sort(times.begin(), times.end());
+
+    const double medianMs = times[times.size() / 2];
+    if (baselineMs == 0.0)
+      baselineMs = medianMs;
+
+    printf("%u workers  %8.2f ms median  %8.2f ms min  %5.2fx  (%u loaded)\n",
+           workerCount, medianMs, times.front(), baselineMs / medianMs, buttonMapCount);
+  }
+
+  CFilesystem::Deinitialize();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,360 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+/*
+ * Measures the event pipeline with 1..64 synthetic joysticks. The joysticks
+ * are played from a generated trace by the replay interface, as fast as
+ * possible, so every frame carries new input for every joystick.
+ *
+ * Measured per frame:
+ *   joystick  CJoystick::GetEvents() for each joystick, into a reused arena
+ *   manager   CJoystickManager::GetEvents() and ProcessEvents(), as called
+ *             by the add-on for each frame. The frontend passes an empty
+ *             vector, which costs one allocation to convert the events.
+ *   table     The same, with changes detected through the state table
+ *   scan      CJoystickManager::PerformJoystickScan() with no changes
+ *
+ * Exits with an error if collecting events allocates in the steady state, or
+ * if the manager allocates more than the converted events once per frame.
+ */
+
+#include "api/Joystick.h"
+#include "api/JoystickManager.h"
+#include "api/replay/InputTrace.h"
+#include "api/replay/JoystickInterfaceReplay.h"
+#include "log/Log.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace JOYSTICK;
+
+// --- Allocation counting -----------------------------------------------------
+
+namespace
+{
+  std::atomic<uint64_t> g_allocations{0};
+}
+
+void* operator new(size_t size)
+{
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+
+  void* ptr = malloc(size > 0 ? size : 1);
+  if (ptr == nullptr)
+    throw std::bad_alloc();
+
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+  free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+  free(ptr);
+}
+
+// --- Benchmark ---------------------------------------------------------------
+
+namespace
+{
+  const unsigned int TRACE_FRAMES  = 600; // Frames in the trace, replayed in a loop
+  const unsigned int WARMUP_FRAMES = 200;
+  const unsigned int FRAMES        = 5000;
+  const unsigned int SCANS         = 500;
+  const int64_t      FRAME_TIME_US = 16667;
+
+  // The frontend's event vector is the only allocation of a manager frame
+  const double MAX_MANAGER_ALLOCS_PER_FRAME = 1.0;
+
+  const unsigned int JOYSTICK_COUNTS[] = { 1, 2, 4, 8, 16, 32, 64 };
+
+  struct Layout
+  {
+    unsigned int buttons;
+    unsigned int hats;
+    unsigned int axes;
+  };
+
+  /*!
+   * \brief Vary the layout between gamepads, arcade sticks and HOTAS setups
+   */
+  Layout GetLayout(unsigned int device)
+  {
+    Layout layout;
+    layout.buttons = 8 + (device * 7) % 25;
+    layout.hats    = device % 2;
+    layout.axes    = 2 + (device * 3) % 7;
+    return layout;
+  }
+
+  void Append(std::vector<uint8_t>& buffer, const void* data, size_t size)
+  {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    buffer.insert(buffer.end(), bytes, bytes + size);
+  }
+
+  void AppendEvent(std::vector<uint8_t>& buffer, unsigned int device, ETraceRecord type, unsigned int index, int64_t timestampUs, float value)
+  {
+    TraceEventRecord record = { };
+    record.header.size   = sizeof(record);
+    record.header.type   = static_cast<uint8_t>(type);
+    record.header.device = static_cast<uint8_t>(device);
+    record.index         = static_cast<uint16_t>(index);
+    record.timestampUs   = timestampUs;
+    record.value         = value;
+
+    Append(buffer, &record, sizeof(record));
+  }
+
+  /*!
+   * \brief Write a trace where, every frame, each joystick moves two axes and
+   *        toggles a button, and every fourth frame moves its hat
+   */
+  bool WriteTrace(const std::string& path, unsigned int joystickCount)
+  {
+    std::vector<uint8_t> buffer;
+
+    const TraceFileHeader header = { INPUT_TRACE_MAGIC, INPUT_TRACE_VERSION, 0 };
+    Append(buffer, &header, sizeof(header));
+
+    for (unsigned int device = 0; device < joystickCount; device++)
+    {
+      const Layout layout = GetLayout(device);
+      const std::string name = "Benchmark Joystick " + std::to_string(device);
+      const std::string provider = "replay";
+
+      TraceDeviceRecord record = { };
+      record.header.size    = static_cast<uint16_t>(TraceRecordSize(sizeof(record) + name.size() + provider.size()));
+      record.header.type    = static_cast<uint8_t>(ETraceRecord::DEVICE);
+      record.header.device  = static_cast<uint8_t>(device);
+      record.buttonCount    = layout.buttons;
+      record.hatCount       = layout.hats;
+      record.axisCount      = layout.axes;
+      record.nameLength     = static_cast<uint16_t>(name.size());
+      record.providerLength = static_cast<uint16_t>(provider.size());
+
+      Append(buffer, &record, sizeof(record));
+      Append(buffer, name.c_str(), name.size());
+      Append(buffer, provider.c_str(), provider.size());
+      buffer.resize(buffer.size() + record.header.size - sizeof(record) - name.size() - provider.size());
+    }
+
+    for (unsigned int frame = 0; frame < TRACE_FRAMES; frame++)
+    {
+      const int64_t timestampUs = frame * FRAME_TIME_US;
+
+      for (unsigned int device = 0; device < joystickCount; device++)
+      {
+        const Layout layout = GetLayout(device);
+        const float phase = static_cast<float>(frame + device) / 32.0f;
+
+        AppendEvent(buffer, device, ETraceRecord::AXIS, frame % layout.axes, timestampUs, std::sin(phase));
+        AppendEvent(buffer, device, ETraceRecord::AXIS, (frame + 1) % layout.axes, timestampUs, std::cos(phase));
+        AppendEvent(buffer, device, ETraceRecord::BUTTON, (frame / 2) % layout.buttons, timestampUs, static_cast<float>(frame % 2 == 0));
+
+        if (layout.hats > 0 && frame % 4 == 0)
+          AppendEvent(buffer, device, ETraceRecord::HAT, 0, timestampUs, static_cast<float>(1 << ((frame / 4) % 4)));
+      }
+    }
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr)
+      return false;
+
+    const bool bSuccess = (fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size());
+    fclose(file);
+
+    return bSuccess;
+  }
+
+  struct Result
+  {
+    double nsPerFrame;
+    double allocsPerFrame;
+    double eventsPerFrame;
+  };
+
+  template<typename FUNC>
+  Result Measure(unsigned int frames, FUNC func)
+  {
+    uint64_t eventCount = 0;
+
+    const uint64_t allocationsBefore = g_allocations.load(std::memory_order_relaxed);
+    const auto start = std::chrono::steady_clock::now();
+
+    for (unsigned int frame = 0; frame < frames; frame++)
+      eventCount += func();
+
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const uint64_t allocations = g_allocations.load(std::memory_order_relaxed) - allocationsBefore;
+
+    Result result;
+    result.nsPerFrame = std::chrono::duration<double, std::nano>(elapsed).count() / frames;
+    result.allocsPerFrame = static_cast<double>(allocations) / frames;
+    result.eventsPerFrame = static_cast<double>(eventCount) / frames;
+    return result;
+  }
+
+  void Print(const char* name, unsigned int joystickCount, const Result& result)
+  {
+    printf("%-9s %3u joysticks  %10.1f ns/frame  %7.2f allocs/frame  %7.1f events/frame\n",
+           name, joystickCount, result.nsPerFrame, result.allocsPerFrame, result.eventsPerFrame);
+  }
+
+  // CJoystick::GetEvents() on joysticks outside the manager
+  bool BenchmarkJoysticks(const std::string& tracePath, unsigned int joystickCount)
+  {
+    CJoystickInterfaceReplay iface(tracePath, EReplaySpeed::FAST, true);
+    if (!iface.Initialize())
+      return false;
+
+    JoystickVector joysticks;
+    iface.ScanForJoysticks(joysticks);
+
+    for (const JoystickPtr& joystick : joysticks)
+      joystick->Initialize();
+
+    JoystickEventVector events;
+
+    auto frame = [&joysticks, &events]()
+      {
+        events.clear();
+        for (const JoystickPtr& joystick : joysticks)
+          joystick->GetEvents(events);
+        return events.size();
+      };
+
+    Measure(WARMUP_FRAMES, frame);
+
+    const Result result = Measure(FRAMES, frame);
+    Print("joystick", joystickCount, result);
+
+    if (result.allocsPerFrame != 0.0)
+    {
+      fprintf(stderr, "Collecting events allocated memory in the steady state\n");
+      return false;
+    }
+
+    return true;
+  }
+
+  bool CheckManagerAllocations(const Result& result)
+  {
+    if (result.allocsPerFrame > MAX_MANAGER_ALLOCS_PER_FRAME)
+    {
+      fprintf(stderr, "Processing events allocated more than the frontend's event vector\n");
+      return false;
+    }
+
+    return true;
+  }
+
+  // CJoystickManager::GetEvents() and PerformJoystickScan()
+  bool BenchmarkManager(const std::string& tracePath, unsigned int joystickCount)
+  {
+    setenv("JOYSTICK_REPLAY_TRACE", tracePath.c_str(), 1);
+
+    CJoystickManager& manager = CJoystickManager::Get();
+    if (!manager.Initialize(nullptr))
+      return false;
+
+    bool bSuccess = true;
+
+    JoystickVector joysticks;
+    manager.PerformJoystickScan(joysticks);
+
+    auto frame = [&manager]()
+      {
+        std::vector<kodi::addon::PeripheralEvent> events;
+        manager.GetEvents(events);
+        manager.ProcessEvents();
+        return events.size();
+      };
+
+    Measure(WARMUP_FRAMES, frame);
+
+    const Result managerResult = Measure(FRAMES, frame);
+    Print("manager", joystickCount, managerResult);
+    if (!CheckManagerAllocations(managerResult))
+      bSuccess = false;
+
+    manager.SetStateTableEnabled(true);
+
+    Measure(WARMUP_FRAMES, frame);
+
+    const Result tableResult = Measure(FRAMES, frame);
+    Print("table", joystickCount, tableResult);
+    if (!CheckManagerAllocations(tableResult))
+      bSuccess = false;
+
+    manager.SetStateTableEnabled(false);
+
+    auto scan = [&manager]()
+      {
+        JoystickVector results;
+        manager.PerformJoystickScan(results);
+        return 0;
+      };
+
+    Print("scan", joystickCount, Measure(SCANS, scan));
+
+    manager.Deinitialize();
+
+    return bSuccess;
+  }
+}
+
+int main()
+{
+  CLog::Get().SetLevel(SYS_LOG_ERROR);
+
+  setenv("JOYSTICK_REPLAY_SPEED", "fast", 1);
+  setenv("JOYSTICK_REPLAY_LOOP", "1", 1);
+
+  char tracePath[] = "/tmp/joystick_bench_XXXXXX";
+  const int fd = mkstemp(tracePath);
+  if (fd < 0)
+  {
+    perror("mkstemp");
+    return EXIT_FAILURE;
+  }
+  close(fd);
+
+  int status = EXIT_SUCCESS;
+
+  for (unsigned int joystickCount : JOYSTICK_COUNTS)
+  {
+    if (!WriteTrace(tracePath, joystickCount))
+    {
+      fprintf(stderr, "Failed to write trace %s\n", tracePath);
+      status = EXIT_FAILURE;
+      break;
+    }
+
+    if (!BenchmarkJoysticks(tracePath, joystickCount))
+      status = EXIT_FAILURE;
+
+    if (!BenchmarkManager(tracePath, joystickCount))
+      status = EXIT_FAILURE;
+  }
+
+  unlink(tracePath);
+
+  return status;
+}
@@ -0,0 +1,196 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+/*
+ * Feeds bursts of js_event records through a pipe, comparing one read() per
+ * event (how CJoystickLinux used to scan) with the batched, coalescing reads
+ * of CJoystickLinuxReader.
+ */
+
+#include "api/linux/JoystickLinuxReader.h"
+
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/joystick.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace JOYSTICK;
+
+namespace
+{
+  const unsigned int FRAMES        = 20000;
+  const unsigned int BUTTON_COUNT  = 12;
+  const unsigned int AXIS_COUNT    = 6;
+  const unsigned int SWEEP_UPDATES = 20; // Axis updates per stick axis per frame
+
+  struct Stats
+  {
+    uint64_t syscalls = 0;
+    uint64_t applied = 0;   // Events applied to the joystick state
+    uint64_t delivered = 0; // Changes that would be reported to the frontend
+  };
+
+  struct State
+  {
+    std::vector<int16_t> buttons = std::vector<int16_t>(BUTTON_COUNT);
+    std::vector<int16_t> axes = std::vector<int16_t>(AXIS_COUNT);
+    std::vector<int16_t> reportedButtons = std::vector<int16_t>(BUTTON_COUNT);
+    std::vector<int16_t> reportedAxes = std::vector<int16_t>(AXIS_COUNT);
+
+    void Apply(const js_event& event, Stats& stats)
+    {
+      stats.applied++;
+      if (event.type == JS_EVENT_BUTTON)
+        buttons[event.number] = event.value;
+      else if (event.type == JS_EVENT_AXIS)
+        axes[event.number] = event.value;
+    }
+
+    // What GetEvents() does at the end of a frame
+    void Report(Stats& stats)
+    {
+      for (unsigned int i = 0; i < BUTTON_COUNT; i++)
+      {
+        if (buttons[i] != reportedButtons[i])
+        {
+          reportedButtons[i] = buttons[i];
+          stats.delivered++;
+        }
+      }
+      for (unsigned int i = 0; i < AXIS_COUNT; i++)
+      {
+        if (axes[i] != reportedAxes[i])
+        {
+          reportedAxes[i] = axes[i];
+          stats.delivered++;
+        }
+      }
+    }
+  };
+
+  /*!
+   * \brief A frame's worth of input: both sticks sweeping plus a button
+   */
+  std::vector<js_event> GenerateFrame(unsigned int frame)
+  {
+    std::vector<js_event> events;
+
+    for (unsigned int i = 0; i < SWEEP_UPDATES; i++)
+    {
+      for (unsigned int axis = 0; axis < 4; axis++)
+      {
+        js_event event = { };
+        event.type   = JS_EVENT_AXIS;
+        event.number = axis;
+        event.value  = static_cast<int16_t>((frame * SWEEP_UPDATES + i) * 97 + axis * 1000);
+        events.push_back(event);
+      }
+    }
+
+    js_event button = { };
+    button.type   = JS_EVENT_BUTTON;
+    button.number = frame % BUTTON_COUNT;
+    button.value  = (frame / BUTTON_COUNT) & 1;
+    events.push_back(button);
+
+    return events;
+  }
+
+  void ScanSingle(int fd, State& state, Stats& stats)
+  {
+    js_event event;
+
+    while (true)
+    {
+      stats.syscalls++;
+      if (read(fd, &event, sizeof(event)) != sizeof(event))
+        break;
+
+      state.Apply(event, stats);
+    }
+  }
+
+  void ScanBatched(int fd, CJoystickLinuxReader& reader, State& state, Stats& stats)
+  {
+    do
+    {
+      stats.syscalls++;
+      const int count = reader.Read(fd);
+      if (count < 0)
+        break;
+
+      for (unsigned int i = 0; i < static_cast<unsigned int>(count); i++)
+        state.Apply(reader.Event(i), stats);
+    } while (!reader.IsDrained());
+  }
+
+  template<typename SCAN>
+  void Run(const char* name, SCAN scan)
+  {
+    int fds[2];
+    if (pipe(fds) < 0)
+    {
+      fprintf(stderr, "Failed to create pipe: %s\n", strerror(errno));
+      exit(EXIT_FAILURE);
+    }
+
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+
+    State state;
+    Stats stats;
+    std::chrono::steady_clock::duration elapsed{0};
+
+    for (unsigned int frame = 0; frame < FRAMES; frame++)
+    {
+      const std::vector<js_event> events = GenerateFrame(frame);
+      if (write(fds[1], events.data(), events.size() * sizeof(js_event)) < 0)
+        break;
+
+      auto start = std::chrono::steady_clock::now();
+      scan(fds[0], state, stats);
+      elapsed += std::chrono::steady_clock::now() - start;
+
+      state.Report(stats);
+    }
+
+    close(fds[0]);
+    close(fds[1]);
+
+    const double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+
+    printf("%-8s %8.1f ns/frame  %6.2f syscalls/frame  %6.1f applied/frame  %5.2f delivered/frame  %6.3f syscalls/delivered\n",
+           name, ns / FRAMES,
+           static_cast<double>(stats.syscalls) / FRAMES,
+           static_cast<double>(stats.applied) / FRAMES,
+           static_cast<double>(stats.delivered) / FRAMES,
+           static_cast<double>(stats.syscalls) / stats.delivered);
+  }
+}
+
+int main()
+{
+  printf("Scanning %u frames of %zu events through a pipe\n", FRAMES, GenerateFrame(0).size());
+
+  Run("single", [](int fd, State& state, Stats& stats)
+    {
+      ScanSingle(fd, state, stats);
+    });
+
+  CJoystickLinuxReader reader;
+  Run("batched", [&reader](int fd, State& state, Stats& stats)
+    {
+      ScanBatched(fd, reader, state, stats);
+    });
+
+  return EXIT_SUCCESS;
+}
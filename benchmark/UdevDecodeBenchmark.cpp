@@ -0,0 +1,269 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+/*
+ * Decodes a synthetic evdev event stream, comparing the std::map lookups that
+ * CJoystickUdev used to do with the direct-index tables of CUdevDecodeTable.
+ */
+
+#include "api/udev/UdevDecodeTable.h"
+
+#include <chrono>
+#include <linux/input.h>
+#include <map>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+using namespace JOYSTICK;
+
+namespace
+{
+  const unsigned int EVENT_COUNT = 1 << 20;
+  const unsigned int ITERATIONS  = 20;
+
+  // Layout of a typical gamepad
+  const unsigned int KEYCODES[] = {
+    BTN_SOUTH, BTN_EAST, BTN_NORTH, BTN_WEST, BTN_TL, BTN_TR,
+    BTN_SELECT, BTN_START, BTN_MODE, BTN_THUMBL, BTN_THUMBR,
+  };
+
+  struct AbsCode
+  {
+    unsigned int code;
+    int32_t      minimum;
+    int32_t      maximum;
+  };
+
+  const AbsCode ABS_CODES[] = {
+    { ABS_X,     -32768, 32767 },
+    { ABS_Y,     -32768, 32767 },
+    { ABS_Z,     0,      255   },
+    { ABS_RX,    -32768, 32767 },
+    { ABS_RY,    -32768, 32767 },
+    { ABS_RZ,    0,      255   },
+    { ABS_HAT0X, -1,     1     },
+    { ABS_HAT0Y, -1,     1     },
+  };
+
+  struct State
+  {
+    std::vector<uint8_t> buttons;
+    std::vector<float>   axes;
+
+    float Checksum() const
+    {
+      float sum = 0.0f;
+      for (uint8_t button : buttons)
+        sum += button;
+      for (float axis : axes)
+        sum += axis;
+      return sum;
+    }
+  };
+
+  /*!
+   * \brief The decoder as it was before CUdevDecodeTable
+   */
+  class CMapDecoder
+  {
+  public:
+    struct Axis
+    {
+      unsigned int  axisIndex;
+      input_absinfo axisInfo;
+    };
+
+    CMapDecoder()
+    {
+      unsigned int buttons = 0;
+      for (unsigned int keycode : KEYCODES)
+        m_button_bind[keycode] = buttons++;
+
+      unsigned int axes = 0;
+      for (const AbsCode& abs : ABS_CODES)
+      {
+        input_absinfo info = { };
+        info.minimum = abs.minimum;
+        info.maximum = abs.maximum;
+        m_axes_bind[abs.code] = { axes++, info };
+      }
+    }
+
+    void Decode(const input_event& event, State& state) const
+    {
+      int code = event.code;
+
+      switch (event.type)
+      {
+        case EV_KEY:
+        {
+          if (code >= BTN_MISC || (code >= KEY_UP && code <= KEY_DOWN))
+          {
+            auto it = m_button_bind.find(code);
+            if (it != m_button_bind.end())
+              state.buttons[it->second] = event.value ? 1 : 0;
+          }
+          break;
+        }
+        case EV_ABS:
+        {
+          if (code < ABS_MISC)
+          {
+            auto it = m_axes_bind.find(code);
+            if (it != m_axes_bind.end())
+            {
+              const input_absinfo& info = it->second.axisInfo;
+              const long maxAxisAmount = event.value >= 0 ? info.maximum : -info.minimum;
+              state.axes[it->second.axisIndex] = maxAxisAmount != 0 ? (float)event.value / (float)maxAxisAmount : 0.0f;
+            }
+          }
+          break;
+        }
+        default:
+          break;
+      }
+    }
+
+  private:
+    std::map<unsigned int, unsigned int> m_button_bind;
+    std::map<unsigned int, Axis>         m_axes_bind;
+  };
+
+  class CTableDecoder
+  {
+  public:
+    CTableDecoder()
+    {
+      for (unsigned int keycode : KEYCODES)
+        m_table.AddButton(keycode);
+
+      for (const AbsCode& abs : ABS_CODES)
+      {
+        input_absinfo info = { };
+        info.minimum = abs.minimum;
+        info.maximum = abs.maximum;
+        m_table.AddAxis(abs.code, info);
+      }
+    }
+
+    void Decode(const input_event& event, State& state) const
+    {
+      switch (event.type)
+      {
+        case EV_KEY:
+        {
+          const int buttonIndex = m_table.GetButton(event.code);
+          if (buttonIndex >= 0)
+            state.buttons[buttonIndex] = event.value ? 1 : 0;
+          break;
+        }
+        case EV_ABS:
+        {
+          const UdevAxisBinding* axis = m_table.GetAxis(event.code);
+          if (axis != nullptr)
+            state.axes[axis->axisIndex] = axis->Normalize(event.value);
+          break;
+        }
+        default:
+          break;
+      }
+    }
+
+  private:
+    CUdevDecodeTable m_table;
+  };
+
+  std::vector<input_event> GenerateEvents()
+  {
+    std::vector<input_event> events;
+    events.reserve(EVENT_COUNT);
+
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<unsigned int> percent(0, 99);
+    std::uniform_int_distribution<unsigned int> keyIndex(0, sizeof(KEYCODES) / sizeof(KEYCODES[0]) - 1);
+    std::uniform_int_distribution<unsigned int> absIndex(0, sizeof(ABS_CODES) / sizeof(ABS_CODES[0]) - 1);
+
+    while (events.size() < EVENT_COUNT)
+    {
+      input_event event = { };
+
+      // Roughly what a gamepad produces while playing: mostly stick motion,
+      // some buttons and a report after every few events
+      const unsigned int kind = percent(rng);
+      if (kind < 70)
+      {
+        const AbsCode& abs = ABS_CODES[absIndex(rng)];
+        std::uniform_int_distribution<int32_t> value(abs.minimum, abs.maximum);
+        event.type  = EV_ABS;
+        event.code  = abs.code;
+        event.value = value(rng);
+      }
+      else if (kind < 85)
+      {
+        event.type  = EV_KEY;
+        event.code  = KEYCODES[keyIndex(rng)];
+        event.value = percent(rng) & 1;
+      }
+      else if (kind < 90)
+      {
+        // Unbound codes, e.g. from a keyboard interface on the same device
+        event.type  = EV_KEY;
+        event.code  = KEY_A + percent(rng) % 26;
+        event.value = 1;
+      }
+      else
+      {
+        event.type = EV_SYN;
+        event.code = SYN_REPORT;
+      }
+
+      events.push_back(event);
+    }
+
+    return events;
+  }
+
+  template<typename DECODER>
+  void Run(const char* name, const DECODER& decoder, const std::vector<input_event>& events)
+  {
+    State state;
+    state.buttons.resize(sizeof(KEYCODES) / sizeof(KEYCODES[0]));
+    state.axes.resize(sizeof(ABS_CODES) / sizeof(ABS_CODES[0]));
+
+    double best = 0.0;
+    for (unsigned int i = 0; i < ITERATIONS; i++)
+    {
+      auto start = std::chrono::steady_clock::now();
+
+      for (const input_event& event : events)
+        decoder.Decode(event, state);
+
+      auto end = std::chrono::steady_clock::now();
+
+      const double ns = std::chrono::duration<double, std::nano>(end - start).count() / events.size();
+      if (i == 0 || ns < best)
+        best = ns;
+    }
+
+    printf("%-8s %6.2f ns/event  (checksum %.3f)\n", name, best, state.Checksum());
+  }
+}
+
+int main()
+{
+  const std::vector<input_event> events = GenerateEvents();
+
+  printf("Decoding %u events, best of %u runs\n", EVENT_COUNT, ITERATIONS);
+
+  Run("map", CMapDecoder(), events);
+  Run("table", CTableDecoder(), events);
+
+  return EXIT_SUCCESS;
+}
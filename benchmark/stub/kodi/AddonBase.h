@@ -0,0 +1,45 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+/*
+ * Minimal stand-in for the Kodi add-on API, providing only what the joystick
+ * core needs so that benchmarks can run without Kodi.
+ */
+
+#pragma once
+
+#include <string>
+
+typedef enum ADDON_LOG
+{
+  ADDON_LOG_DEBUG = 0,
+  ADDON_LOG_INFO = 1,
+  ADDON_LOG_WARNING = 2,
+  ADDON_LOG_ERROR = 3,
+  ADDON_LOG_FATAL = 4,
+} ADDON_LOG;
+
+namespace kodi
+{
+  class CSettingValue
+  {
+  public:
+    explicit CSettingValue(const std::string& value = "") : m_str(value) { }
+
+    std::string GetString() const { return m_str; }
+    int GetInt() const { return std::stoi(m_str); }
+    unsigned int GetUInt() const { return static_cast<unsigned int>(std::stoul(m_str)); }
+    bool GetBoolean() const { return m_str == "true" || m_str == "1"; }
+    float GetFloat() const { return std::stof(m_str); }
+
+  private:
+    std::string m_str;
+  };
+
+  inline void Log(const ADDON_LOG, const char*, ...) { }
+}
@@ -0,0 +1,143 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+/*
+ * Subset of the VFS API used by the button map storage, implemented on the
+ * local filesystem.
+ */
+
+#pragma once
+
+#include <dirent.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+namespace kodi
+{
+namespace vfs
+{
+  class CDirEntry
+  {
+  public:
+    CDirEntry(const std::string& label = "",
+              const std::string& path = "",
+              bool bFolder = false,
+              int64_t size = -1,
+              time_t dateTime = 0)
+      : m_label(label), m_path(path), m_bFolder(bFolder), m_size(size), m_dateTime(dateTime) { }
+
+    const std::string& Label(void) const { return m_label; }
+    const std::string& Path(void) const { return m_path; }
+    bool IsFolder(void) const { return m_bFolder; }
+    int64_t Size(void) const { return m_size; }
+    time_t DateTime(void) const { return m_dateTime; }
+
+    void SetLabel(const std::string& label) { m_label = label; }
+    void SetPath(const std::string& path) { m_path = path; }
+    void SetFolder(bool bFolder) { m_bFolder = bFolder; }
+    void SetSize(int64_t size) { m_size = size; }
+    void SetDateTime(time_t dateTime) { m_dateTime = dateTime; }
+
+  private:
+    std::string m_label;
+    std::string m_path;
+    bool m_bFolder;
+    int64_t m_size;
+    time_t m_dateTime;
+  };
+
+  class FileStatus
+  {
+  public:
+    uint32_t GetDeviceId(void) const { return static_cast<uint32_t>(m_stat.st_dev); }
+    uint64_t GetFileSerialNumber(void) const { return m_stat.st_ino; }
+    uint64_t GetSize(void) const { return m_stat.st_size; }
+    time_t GetModificationTime(void) const { return m_stat.st_mtime; }
+    time_t GetStatusTime(void) const { return m_stat.st_ctime; }
+    bool GetIsDirectory(void) const { return S_ISDIR(m_stat.st_mode); }
+
+    struct stat m_stat = { };
+  };
+
+  inline bool StatFile(const std::string& filename, FileStatus& buffer)
+  {
+    return stat(filename.c_str(), &buffer.m_stat) == 0;
+  }
+
+  inline bool FileExists(const std::string& filename, bool bUseCache = false)
+  {
+    struct stat buffer;
+    return stat(filename.c_str(), &buffer) == 0 && !S_ISDIR(buffer.st_mode);
+  }
+
+  inline bool DirectoryExists(const std::string& path)
+  {
+    struct stat buffer;
+    return stat(path.c_str(), &buffer) == 0 && S_ISDIR(buffer.st_mode);
+  }
+
+  inline bool CreateDirectory(const std::string& path) { return mkdir(path.c_str(), 0755) == 0; }
+  inline bool RemoveDirectory(const std::string& path) { return rmdir(path.c_str()) == 0; }
+  inline bool DeleteFile(const std::string& filename) { return unlink(filename.c_str()) == 0; }
+  inline bool RenameFile(const std::string& filename, const std::string& newFileName) { return rename(filename.c_str(), newFileName.c_str()) == 0; }
+
+  /*!
+   * \brief List a directory. Folders are always listed, files only if they
+   *        match one of the extensions in the '|'-separated mask.
+   */
+  inline bool GetDirectory(const std::string& path, const std::string& mask, std::vector<CDirEntry>& items)
+  {
+    DIR* dir = opendir(path.c_str());
+    if (dir == nullptr)
+      return false;
+
+    while (struct dirent* entry = readdir(dir))
+    {
+      const std::string name = entry->d_name;
+      if (name == "." || name == "..")
+        continue;
+
+      const std::string itemPath = path + "/" + name;
+
+      struct stat buffer;
+      if (stat(itemPath.c_str(), &buffer) != 0)
+        continue;
+
+      const bool bFolder = S_ISDIR(buffer.st_mode);
+
+      bool bMatch = bFolder || mask.empty();
+      for (size_t start = 0; !bMatch && start < mask.size(); )
+      {
+        size_t end = mask.find('|', start);
+        if (end == std::string::npos)
+          end = mask.size();
+
+        const std::string extension = mask.substr(start, end - start);
+        if (!extension.empty() && name.size() >= extension.size() &&
+            name.compare(name.size() - extension.size(), extension.size(), extension) == 0)
+          bMatch = true;
+
+        start = end + 1;
+      }
+
+      if (bMatch)
+        items.emplace_back(name, itemPath, bFolder, buffer.st_size, buffer.st_mtime);
+    }
+
+    closedir(dir);
+
+    return true;
+  }
+}
+}
@@ -0,0 +1,326 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <array>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Subset of the peripheral API used by the joystick core
+
+typedef enum PERIPHERAL_ERROR
+{
+  PERIPHERAL_NO_ERROR = 0,
+  PERIPHERAL_ERROR_UNKNOWN = -1,
+  PERIPHERAL_ERROR_FAILED = -2,
+  PERIPHERAL_ERROR_INVALID_PARAMETERS = -3,
+  PERIPHERAL_ERROR_NOT_IMPLEMENTED = -4,
+  PERIPHERAL_ERROR_NOT_CONNECTED = -5,
+  PERIPHERAL_ERROR_CONNECTION_FAILED = -6,
+} PERIPHERAL_ERROR;
+
+typedef enum PERIPHERAL_TYPE
+{
+  PERIPHERAL_TYPE_UNKNOWN,
+  PERIPHERAL_TYPE_JOYSTICK,
+  PERIPHERAL_TYPE_KEYBOARD,
+} PERIPHERAL_TYPE;
+
+typedef enum PERIPHERAL_EVENT_TYPE
+{
+  PERIPHERAL_EVENT_TYPE_NONE,
+  PERIPHERAL_EVENT_TYPE_DRIVER_BUTTON,
+  PERIPHERAL_EVENT_TYPE_DRIVER_HAT,
+  PERIPHERAL_EVENT_TYPE_DRIVER_AXIS,
+  PERIPHERAL_EVENT_TYPE_SET_MOTOR,
+} PERIPHERAL_EVENT_TYPE;
+
+typedef enum JOYSTICK_STATE_BUTTON
+{
+  JOYSTICK_STATE_BUTTON_UNPRESSED = 0x0,
+  JOYSTICK_STATE_BUTTON_PRESSED = 0x1,
+} JOYSTICK_STATE_BUTTON;
+
+typedef enum JOYSTICK_STATE_HAT
+{
+  JOYSTICK_STATE_HAT_UNPRESSED = 0x0,
+  JOYSTICK_STATE_HAT_LEFT = 0x1,
+  JOYSTICK_STATE_HAT_RIGHT = 0x2,
+  JOYSTICK_STATE_HAT_UP = 0x4,
+  JOYSTICK_STATE_HAT_DOWN = 0x8,
+  JOYSTICK_STATE_HAT_LEFT_UP = 0x5,
+  JOYSTICK_STATE_HAT_LEFT_DOWN = 0x9,
+  JOYSTICK_STATE_HAT_RIGHT_UP = 0x6,
+  JOYSTICK_STATE_HAT_RIGHT_DOWN = 0xA,
+} JOYSTICK_STATE_HAT;
+
+typedef float JOYSTICK_STATE_AXIS;
+typedef float JOYSTICK_STATE_MOTOR;
+
+typedef enum JOYSTICK_DRIVER_PRIMITIVE_TYPE
+{
+  JOYSTICK_DRIVER_PRIMITIVE_TYPE_UNKNOWN,
+  JOYSTICK_DRIVER_PRIMITIVE_TYPE_BUTTON,
+  JOYSTICK_DRIVER_PRIMITIVE_TYPE_HAT_DIRECTION,
+  JOYSTICK_DRIVER_PRIMITIVE_TYPE_SEMIAXIS,
+  JOYSTICK_DRIVER_PRIMITIVE_TYPE_MOTOR,
+  JOYSTICK_DRIVER_PRIMITIVE_TYPE_KEY,
+  JOYSTICK_DRIVER_PRIMITIVE_TYPE_MOUSE_BUTTON,
+  JOYSTICK_DRIVER_PRIMITIVE_TYPE_RELPOINTER_DIRECTION,
+} JOYSTICK_DRIVER_PRIMITIVE_TYPE;
+
+typedef enum JOYSTICK_DRIVER_HAT_DIRECTION
+{
+  JOYSTICK_DRIVER_HAT_UNKNOWN,
+  JOYSTICK_DRIVER_HAT_LEFT,
+  JOYSTICK_DRIVER_HAT_RIGHT,
+  JOYSTICK_DRIVER_HAT_UP,
+  JOYSTICK_DRIVER_HAT_DOWN,
+} JOYSTICK_DRIVER_HAT_DIRECTION;
+
+typedef enum JOYSTICK_DRIVER_SEMIAXIS_DIRECTION
+{
+  JOYSTICK_DRIVER_SEMIAXIS_NEGATIVE = -1,
+  JOYSTICK_DRIVER_SEMIAXIS_UNKNOWN = 0,
+  JOYSTICK_DRIVER_SEMIAXIS_POSITIVE = 1,
+} JOYSTICK_DRIVER_SEMIAXIS_DIRECTION;
+
+typedef enum JOYSTICK_DRIVER_MOUSE_INDEX
+{
+  JOYSTICK_DRIVER_MOUSE_INDEX_UNKNOWN,
+  JOYSTICK_DRIVER_MOUSE_INDEX_LEFT,
+  JOYSTICK_DRIVER_MOUSE_INDEX_RIGHT,
+  JOYSTICK_DRIVER_MOUSE_INDEX_MIDDLE,
+  JOYSTICK_DRIVER_MOUSE_INDEX_BUTTON4,
+  JOYSTICK_DRIVER_MOUSE_INDEX_BUTTON5,
+  JOYSTICK_DRIVER_MOUSE_INDEX_WHEEL_UP,
+  JOYSTICK_DRIVER_MOUSE_INDEX_WHEEL_DOWN,
+  JOYSTICK_DRIVER_MOUSE_INDEX_HORIZ_WHEEL_LEFT,
+  JOYSTICK_DRIVER_MOUSE_INDEX_HORIZ_WHEEL_RIGHT,
+} JOYSTICK_DRIVER_MOUSE_INDEX;
+
+typedef enum JOYSTICK_DRIVER_RELPOINTER_DIRECTION
+{
+  JOYSTICK_DRIVER_RELPOINTER_UNKNOWN,
+  JOYSTICK_DRIVER_RELPOINTER_LEFT,
+  JOYSTICK_DRIVER_RELPOINTER_RIGHT,
+  JOYSTICK_DRIVER_RELPOINTER_UP,
+  JOYSTICK_DRIVER_RELPOINTER_DOWN,
+} JOYSTICK_DRIVER_RELPOINTER_DIRECTION;
+
+typedef enum JOYSTICK_FEATURE_TYPE
+{
+  JOYSTICK_FEATURE_TYPE_UNKNOWN,
+  JOYSTICK_FEATURE_TYPE_SCALAR,
+  JOYSTICK_FEATURE_TYPE_ANALOG_STICK,
+  JOYSTICK_FEATURE_TYPE_ACCELEROMETER,
+  JOYSTICK_FEATURE_TYPE_MOTOR,
+  JOYSTICK_FEATURE_TYPE_RELPOINTER,
+  JOYSTICK_FEATURE_TYPE_ABSPOINTER,
+  JOYSTICK_FEATURE_TYPE_WHEEL,
+  JOYSTICK_FEATURE_TYPE_THROTTLE,
+  JOYSTICK_FEATURE_TYPE_KEY,
+} JOYSTICK_FEATURE_TYPE;
+
+typedef enum JOYSTICK_FEATURE_PRIMITIVE
+{
+  JOYSTICK_SCALAR_PRIMITIVE = 0,
+  JOYSTICK_ANALOG_STICK_UP = 0,
+  JOYSTICK_ANALOG_STICK_DOWN = 1,
+  JOYSTICK_ANALOG_STICK_RIGHT = 2,
+  JOYSTICK_ANALOG_STICK_LEFT = 3,
+  JOYSTICK_ACCELEROMETER_POSITIVE_X = 0,
+  JOYSTICK_ACCELEROMETER_POSITIVE_Y = 1,
+  JOYSTICK_ACCELEROMETER_POSITIVE_Z = 2,
+  JOYSTICK_MOTOR_PRIMITIVE = 0,
+  JOYSTICK_WHEEL_LEFT = 0,
+  JOYSTICK_WHEEL_RIGHT = 1,
+  JOYSTICK_THROTTLE_UP = 0,
+  JOYSTICK_THROTTLE_DOWN = 1,
+  JOYSTICK_KEY_PRIMITIVE = 0,
+  JOYSTICK_MOUSE_BUTTON = 0,
+  JOYSTICK_RELPOINTER_UP = 0,
+  JOYSTICK_RELPOINTER_DOWN = 1,
+  JOYSTICK_RELPOINTER_RIGHT = 2,
+  JOYSTICK_RELPOINTER_LEFT = 3,
+  JOYSTICK_PRIMITIVE_MAX = 4,
+} JOYSTICK_FEATURE_PRIMITIVE;
+
+namespace kodi
+{
+namespace addon
+{
+  class Peripheral
+  {
+  public:
+    Peripheral(PERIPHERAL_TYPE type = PERIPHERAL_TYPE_UNKNOWN, const std::string& strName = "") : m_type(type), m_strName(strName) { }
+    virtual ~Peripheral(void) = default;
+
+    PERIPHERAL_TYPE Type(void) const { return m_type; }
+    const std::string& Name(void) const { return m_strName; }
+    uint16_t VendorID(void) const { return m_vendorId; }
+    uint16_t ProductID(void) const { return m_productId; }
+    unsigned int Index(void) const { return m_index; }
+    bool IsVidPidKnown(void) const { return m_vendorId != 0 || m_productId != 0; }
+
+    void SetType(PERIPHERAL_TYPE type) { m_type = type; }
+    void SetName(const std::string& strName) { m_strName = strName; }
+    void SetVendorID(uint16_t vendorId) { m_vendorId = vendorId; }
+    void SetProductID(uint16_t productId) { m_productId = productId; }
+    void SetIndex(unsigned int index) { m_index = index; }
+
+  private:
+    PERIPHERAL_TYPE m_type;
+    std::string m_strName;
+    uint16_t m_vendorId = 0;
+    uint16_t m_productId = 0;
+    unsigned int m_index = 0;
+  };
+
+  class PeripheralEvent
+  {
+  public:
+    PeripheralEvent(void) = default;
+    PeripheralEvent(unsigned int peripheralIndex, unsigned int buttonIndex, JOYSTICK_STATE_BUTTON state)
+      : m_type(PERIPHERAL_EVENT_TYPE_DRIVER_BUTTON), m_peripheralIndex(peripheralIndex), m_driverIndex(buttonIndex), m_buttonState(state) { }
+    PeripheralEvent(unsigned int peripheralIndex, unsigned int hatIndex, JOYSTICK_STATE_HAT state)
+      : m_type(PERIPHERAL_EVENT_TYPE_DRIVER_HAT), m_peripheralIndex(peripheralIndex), m_driverIndex(hatIndex), m_hatState(state) { }
+    PeripheralEvent(unsigned int peripheralIndex, unsigned int axisIndex, JOYSTICK_STATE_AXIS state)
+      : m_type(PERIPHERAL_EVENT_TYPE_DRIVER_AXIS), m_peripheralIndex(peripheralIndex), m_driverIndex(axisIndex), m_axisState(state) { }
+
+    PERIPHERAL_EVENT_TYPE Type(void) const { return m_type; }
+    unsigned int PeripheralIndex(void) const { return m_peripheralIndex; }
+    unsigned int DriverIndex(void) const { return m_driverIndex; }
+    JOYSTICK_STATE_BUTTON ButtonState(void) const { return m_buttonState; }
+    JOYSTICK_STATE_HAT HatState(void) const { return m_hatState; }
+    JOYSTICK_STATE_AXIS AxisState(void) const { return m_axisState; }
+    JOYSTICK_STATE_MOTOR MotorState(void) const { return m_motorState; }
+
+    void SetType(PERIPHERAL_EVENT_TYPE type) { m_type = type; }
+    void SetPeripheralIndex(unsigned int index) { m_peripheralIndex = index; }
+    void SetDriverIndex(unsigned int index) { m_driverIndex = index; }
+    void SetButtonState(JOYSTICK_STATE_BUTTON state) { m_buttonState = state; }
+    void SetHatState(JOYSTICK_STATE_HAT state) { m_hatState = state; }
+    void SetAxisState(JOYSTICK_STATE_AXIS state) { m_axisState = state; }
+    void SetMotorState(JOYSTICK_STATE_MOTOR state) { m_motorState = state; }
+
+  private:
+    PERIPHERAL_EVENT_TYPE m_type = PERIPHERAL_EVENT_TYPE_NONE;
+    unsigned int m_peripheralIndex = 0;
+    unsigned int m_driverIndex = 0;
+    JOYSTICK_STATE_BUTTON m_buttonState = JOYSTICK_STATE_BUTTON_UNPRESSED;
+    JOYSTICK_STATE_HAT m_hatState = JOYSTICK_STATE_HAT_UNPRESSED;
+    JOYSTICK_STATE_AXIS m_axisState = 0.0f;
+    JOYSTICK_STATE_MOTOR m_motorState = 0.0f;
+  };
+
+  class Joystick : public Peripheral
+  {
+  public:
+    Joystick(const std::string& provider = "", const std::string& strName = "")
+      : Peripheral(PERIPHERAL_TYPE_JOYSTICK, strName), m_provider(provider) { }
+    virtual ~Joystick(void) = default;
+
+    const std::string& Provider(void) const { return m_provider; }
+    int RequestedPort(void) const { return m_requestedPort; }
+    unsigned int ButtonCount(void) const { return m_buttonCount; }
+    unsigned int HatCount(void) const { return m_hatCount; }
+    unsigned int AxisCount(void) const { return m_axisCount; }
+    unsigned int MotorCount(void) const { return m_motorCount; }
+    bool SupportsPowerOff(void) const { return m_supportsPowerOff; }
+
+    void SetProvider(const std::string& provider) { m_provider = provider; }
+    void SetRequestedPort(int requestedPort) { m_requestedPort = requestedPort; }
+    void SetButtonCount(unsigned int buttonCount) { m_buttonCount = buttonCount; }
+    void SetHatCount(unsigned int hatCount) { m_hatCount = hatCount; }
+    void SetAxisCount(unsigned int axisCount) { m_axisCount = axisCount; }
+    void SetMotorCount(unsigned int motorCount) { m_motorCount = motorCount; }
+    void SetSupportsPowerOff(bool supportsPowerOff) { m_supportsPowerOff = supportsPowerOff; }
+
+  private:
+    std::string m_provider;
+    int m_requestedPort = -1;
+    unsigned int m_buttonCount = 0;
+    unsigned int m_hatCount = 0;
+    unsigned int m_axisCount = 0;
+    unsigned int m_motorCount = 0;
+    bool m_supportsPowerOff = false;
+  };
+
+  struct DriverPrimitive
+  {
+    DriverPrimitive(void) = default;
+
+    DriverPrimitive(unsigned int hatIndex, JOYSTICK_DRIVER_HAT_DIRECTION direction)
+      : m_type(JOYSTICK_DRIVER_PRIMITIVE_TYPE_HAT_DIRECTION), m_driverIndex(hatIndex), m_hatDirection(direction) { }
+    DriverPrimitive(unsigned int axisIndex, int center, JOYSTICK_DRIVER_SEMIAXIS_DIRECTION direction, unsigned int range)
+      : m_type(JOYSTICK_DRIVER_PRIMITIVE_TYPE_SEMIAXIS), m_driverIndex(axisIndex), m_center(center), m_semiAxisDirection(direction), m_range(range) { }
+    DriverPrimitive(const std::string& keycode)
+      : m_type(JOYSTICK_DRIVER_PRIMITIVE_TYPE_KEY), m_keycode(keycode) { }
+    DriverPrimitive(JOYSTICK_DRIVER_RELPOINTER_DIRECTION direction)
+      : m_type(JOYSTICK_DRIVER_PRIMITIVE_TYPE_RELPOINTER_DIRECTION), m_relPointerDirection(direction) { }
+
+    static DriverPrimitive CreateButton(unsigned int buttonIndex) { DriverPrimitive p; p.m_type = JOYSTICK_DRIVER_PRIMITIVE_TYPE_BUTTON; p.m_driverIndex = buttonIndex; return p; }
+    static DriverPrimitive CreateMotor(unsigned int motorIndex) { DriverPrimitive p; p.m_type = JOYSTICK_DRIVER_PRIMITIVE_TYPE_MOTOR; p.m_driverIndex = motorIndex; return p; }
+    static DriverPrimitive CreateMouseButton(JOYSTICK_DRIVER_MOUSE_INDEX buttonIndex) { DriverPrimitive p; p.m_type = JOYSTICK_DRIVER_PRIMITIVE_TYPE_MOUSE_BUTTON; p.m_driverIndex = buttonIndex; return p; }
+
+    bool operator==(const DriverPrimitive& other) const
+    {
+      return m_type == other.m_type &&
+             m_driverIndex == other.m_driverIndex &&
+             m_hatDirection == other.m_hatDirection &&
+             m_center == other.m_center &&
+             m_semiAxisDirection == other.m_semiAxisDirection &&
+             m_range == other.m_range &&
+             m_keycode == other.m_keycode &&
+             m_relPointerDirection == other.m_relPointerDirection;
+    }
+
+    JOYSTICK_DRIVER_PRIMITIVE_TYPE Type(void) const { return m_type; }
+    unsigned int DriverIndex(void) const { return m_driverIndex; }
+    JOYSTICK_DRIVER_HAT_DIRECTION HatDirection(void) const { return m_hatDirection; }
+    int Center(void) const { return m_center; }
+    JOYSTICK_DRIVER_SEMIAXIS_DIRECTION SemiAxisDirection(void) const { return m_semiAxisDirection; }
+    unsigned int Range(void) const { return m_range; }
+    const std::string& Keycode(void) const { return m_keycode; }
+    JOYSTICK_DRIVER_MOUSE_INDEX MouseIndex(void) const { return static_cast<JOYSTICK_DRIVER_MOUSE_INDEX>(m_driverIndex); }
+    JOYSTICK_DRIVER_RELPOINTER_DIRECTION RelPointerDirection(void) const { return m_relPointerDirection; }
+
+  private:
+    JOYSTICK_DRIVER_PRIMITIVE_TYPE m_type = JOYSTICK_DRIVER_PRIMITIVE_TYPE_UNKNOWN;
+    unsigned int m_driverIndex = 0;
+    JOYSTICK_DRIVER_HAT_DIRECTION m_hatDirection = JOYSTICK_DRIVER_HAT_UNKNOWN;
+    int m_center = 0;
+    JOYSTICK_DRIVER_SEMIAXIS_DIRECTION m_semiAxisDirection = JOYSTICK_DRIVER_SEMIAXIS_UNKNOWN;
+    unsigned int m_range = 1;
+    std::string m_keycode;
+    JOYSTICK_DRIVER_RELPOINTER_DIRECTION m_relPointerDirection = JOYSTICK_DRIVER_RELPOINTER_UNKNOWN;
+  };
+
+  class JoystickFeature
+  {
+  public:
+    JoystickFeature(const std::string& name = "", JOYSTICK_FEATURE_TYPE type = JOYSTICK_FEATURE_TYPE_UNKNOWN)
+      : m_name(name), m_type(type), m_primitives{} { }
+
+    const std::string& Name(void) const { return m_name; }
+    JOYSTICK_FEATURE_TYPE Type(void) const { return m_type; }
+    const DriverPrimitive& Primitive(JOYSTICK_FEATURE_PRIMITIVE which) const { return m_primitives[which]; }
+    void SetPrimitive(JOYSTICK_FEATURE_PRIMITIVE which, const DriverPrimitive& primitive) { m_primitives[which] = primitive; }
+    std::array<DriverPrimitive, JOYSTICK_PRIMITIVE_MAX>& Primitives(void) { return m_primitives; }
+    const std::array<DriverPrimitive, JOYSTICK_PRIMITIVE_MAX>& Primitives(void) const { return m_primitives; }
+
+  private:
+    std::string m_name;
+    JOYSTICK_FEATURE_TYPE m_type;
+    std::array<DriverPrimitive, JOYSTICK_PRIMITIVE_MAX> m_primitives;
+  };
+}
+}
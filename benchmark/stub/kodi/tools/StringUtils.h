@@ -0,0 +1,51 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string>
+
+namespace kodi
+{
+namespace tools
+{
+  class StringUtils
+  {
+  public:
+    static std::string MakeSafeString(const std::string& str) { return str; }
+    static std::string MakeSafeUrl(const std::string& str) { return str; }
+    static std::string RemoveMACAddress(const std::string& str) { return str; }
+
+    static bool EndsWith(const std::string& str, const std::string& suffix)
+    {
+      return str.size() >= suffix.size() &&
+             str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    static std::string& TrimRight(std::string& str, const char* chars)
+    {
+      str.erase(str.find_last_not_of(chars) + 1);
+      return str;
+    }
+
+    static std::string Format(const char* fmt, ...)
+    {
+      char buffer[1024];
+
+      va_list args;
+      va_start(args, fmt);
+      vsnprintf(buffer, sizeof(buffer), fmt, args);
+      va_end(args);
+
+      return buffer;
+    }
+  };
+}
+}
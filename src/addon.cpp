@@ -10,6 +10,9 @@
 
 #include "addon.h"
 
+#if defined(HAVE_INPUT_NOTIFIER)
+  #include "api/InputNotifier.h"
+#endif
 #include "api/Joystick.h"
 #include "api/JoystickManager.h"
 #include "api/PeripheralScanner.h"
@@ -26,7 +29,8 @@
 using namespace JOYSTICK;
 
 CPeripheralJoystick::CPeripheralJoystick() :
-  m_scanner(nullptr)
+  m_scanner(nullptr),
+  m_inputNotifier(nullptr)
 {
 }
 
@@ -41,6 +45,12 @@ ADDON_STATUS CPeripheralJoystick::Create()
   if (!CJoystickManager::Get().Initialize(m_scanner))
     return ADDON_STATUS_PERMANENT_FAILURE;
 
+#if defined(HAVE_INPUT_NOTIFIER)
+  m_inputNotifier = new CInputNotifier;
+  if (m_inputNotifier->Initialize())
+    CJoystickManager::Get().SetInputCallback(m_inputNotifier);
+#endif
+
   if (!CStorageManager::Get().Initialize(this))
     return ADDON_STATUS_PERMANENT_FAILURE;
 
@@ -71,6 +81,19 @@ CPeripheralJoystick::~CPeripheralJoystick()
   CLog::Get().SetType(SYS_LOG_TYPE_CONSOLE);
 
   delete m_scanner;
+#if defined(HAVE_INPUT_NOTIFIER)
+  delete m_inputNotifier;
+#endif
+}
+
+int CPeripheralJoystick::GetInputNotificationFD() const
+{
+#if defined(HAVE_INPUT_NOTIFIER)
+  if (m_inputNotifier)
+    return m_inputNotifier->GetFD();
+#endif
+
+  return -1;
 }
 
 void CPeripheralJoystick::GetCapabilities(kodi::addon::PeripheralCapabilities& capabilities)
@@ -96,6 +119,11 @@ PERIPHERAL_ERROR CPeripheralJoystick::GetEvents(std::vector<kodi::addon::Periphe
 {
   PERIPHERAL_ERROR result = PERIPHERAL_ERROR_FAILED;
 
+#if defined(HAVE_INPUT_NOTIFIER)
+  if (m_inputNotifier)
+    m_inputNotifier->Acknowledge();
+#endif
+
   if (CJoystickManager::Get().GetEvents(events))
     result = PERIPHERAL_NO_ERROR;
 
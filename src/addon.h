@@ -14,6 +14,7 @@
 
 namespace JOYSTICK
 {
+  class CInputNotifier;
   class CPeripheralScanner;
 }
 
@@ -49,6 +50,18 @@ public:
   void ResetButtonMap(const kodi::addon::Joystick& joystick, const std::string& controller_id) override;
   void PowerOffJoystick(unsigned int index) override;
 
+  /*!
+   * \brief Get a descriptor that becomes readable when GetEvents() has new
+   *        input from joysticks read by the input reactor, or -1 if input
+   *        notification isn't available
+   *
+   * The peripheral API has no way to pass the descriptor to the frontend yet,
+   * so only hosts that load the add-on in-process can wait on it. Built with
+   * ENABLE_INPUT_NOTIFICATION, otherwise this returns -1.
+   */
+  int GetInputNotificationFD() const;
+
 private:
   JOYSTICK::CPeripheralScanner* m_scanner;
+  JOYSTICK::CInputNotifier* m_inputNotifier;
 };
@@ -61,6 +61,15 @@ namespace JOYSTICK
      */
     virtual bool ScanForJoysticks(JoystickVector& joysticks) = 0;
 
+    /*!
+     * \brief Handle joysticks connected or disconnected since the last call
+     *
+     * Interfaces that receive hotplug notifications report each change to
+     * CJoystickManager::AddJoystick() and CJoystickManager::RemoveJoystick()
+     * instead of waiting for the next scan.
+     */
+    virtual void ProcessHotplug(void) { }
+
     /*!
      * \brief Get the button map known to the interface
      *
@@ -0,0 +1,69 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "InputNotifier.h"
+#include "log/Log.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace JOYSTICK;
+
+bool CInputNotifier::Initialize(void)
+{
+  Deinitialize();
+
+  m_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (m_fd < 0)
+  {
+    esyslog("Failed to create input notification descriptor - %s", strerror(errno));
+    return false;
+  }
+
+  m_bSignalled = false;
+
+  return true;
+}
+
+void CInputNotifier::Deinitialize(void)
+{
+  if (m_fd >= 0)
+  {
+    close(m_fd);
+    m_fd = -1;
+  }
+}
+
+void CInputNotifier::Acknowledge(void)
+{
+  if (m_bSignalled)
+  {
+    // The host may have already read the counter
+    uint64_t count;
+    if (read(m_fd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+      esyslog("Failed to reset input notification descriptor - %s", strerror(errno));
+
+    // Clear the flag after draining, so a notification that arrives in
+    // between is either merged into this one or signals again
+    m_bSignalled = false;
+  }
+}
+
+void CInputNotifier::OnInputReady(void)
+{
+  // Skip the write if the host hasn't collected the last notification yet
+  if (m_bSignalled.exchange(true))
+    return;
+
+  const uint64_t count = 1;
+  if (write(m_fd, &count, sizeof(count)) < 0)
+    esyslog("Failed to signal input notification descriptor - %s", strerror(errno));
+}
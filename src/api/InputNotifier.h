@@ -0,0 +1,54 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "JoystickManager.h"
+#include "utils/CommonMacros.h"
+
+#include <atomic>
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Signals an eventfd when joysticks have new input
+   *
+   * The descriptor becomes readable when input is ready, so the host can
+   * block in poll() or epoll_wait() instead of calling GetEvents() on a fixed
+   * cadence. Notifications are coalesced: the descriptor is signalled once
+   * until Acknowledge() is called, no matter how much input arrives.
+   */
+  class DLL_PRIVATE CInputNotifier : public IInputCallback
+  {
+  public:
+    CInputNotifier(void) = default;
+
+    virtual ~CInputNotifier(void) { Deinitialize(); }
+
+    bool Initialize(void);
+    void Deinitialize(void);
+
+    /*!
+     * \brief Get the descriptor to wait on, or -1 if not initialized
+     */
+    int GetFD(void) const { return m_fd; }
+
+    /*!
+     * \brief Reset the descriptor. Must be called before collecting events,
+     *        so that input arriving during collection signals it again.
+     */
+    void Acknowledge(void);
+
+    // implementation of IInputCallback
+    virtual void OnInputReady(void) override;
+
+  private:
+    int               m_fd = -1;
+    std::atomic<bool> m_bSignalled{false};
+  };
+}
@@ -8,6 +8,7 @@
 
 #include "Joystick.h"
 #include "JoystickManager.h"
+#include "JoystickStateTable.h"
 #include "JoystickTranslator.h"
 #include "JoystickUtils.h"
 #include "log/Log.h"
@@ -16,10 +17,68 @@
 
 #include <kodi/tools/StringUtils.h>
 
+#include <algorithm>
+#include <cmath>
+
+#if defined(_MSC_VER)
+  #include <intrin.h>
+#endif
+
 using namespace JOYSTICK;
 
 #define ANALOG_EPSILON  0.0001f
 
+#define LATENCY_LOG_INTERVAL_US  (60 * 1000 * 1000)
+
+// --- Dirty mask helpers ------------------------------------------------------
+
+namespace
+{
+  const unsigned int WORD_BITS = 32;
+
+  void ResizeMask(std::vector<uint32_t>& mask, unsigned int count)
+  {
+    mask.assign((count + WORD_BITS - 1) / WORD_BITS, 0);
+  }
+
+  void SetDirty(std::vector<uint32_t>& mask, unsigned int index)
+  {
+    mask[index / WORD_BITS] |= 1u << (index % WORD_BITS);
+  }
+
+  unsigned int LowestBit(uint32_t word)
+  {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, word);
+    return static_cast<unsigned int>(index);
+#else
+    return static_cast<unsigned int>(__builtin_ctz(word));
+#endif
+  }
+
+  /*!
+   * Invoke a function for the index of every bit set in the mask
+   */
+  template<typename FUNC>
+  void ForEachDirty(const uint32_t* mask, size_t wordCount, FUNC func)
+  {
+    for (unsigned int i = 0; i < wordCount; i++)
+    {
+      for (uint32_t word = mask[i]; word != 0; word &= word - 1)
+        func(i * WORD_BITS + LowestBit(word));
+    }
+  }
+
+  template<typename FUNC>
+  void ForEachDirty(const std::vector<uint32_t>& mask, FUNC func)
+  {
+    ForEachDirty(mask.data(), mask.size(), func);
+  }
+}
+
+// --- CJoystick ---------------------------------------------------------------
+
 CJoystick::CJoystick(EJoystickInterface interfaceType)
 {
   SetProvider(JoystickTranslator::GetInterfaceProvider(interfaceType));
@@ -39,6 +98,17 @@ bool CJoystick::Equals(const CJoystick* rhs) const
          AxisCount()     == rhs->AxisCount();
 }
 
+std::string CJoystick::Identity(void) const
+{
+  return Name() + "|" +
+         std::to_string(VendorID()) + "|" +
+         std::to_string(ProductID()) + "|" +
+         std::to_string(RequestedPort()) + "|" +
+         std::to_string(ButtonCount()) + "|" +
+         std::to_string(HatCount()) + "|" +
+         std::to_string(AxisCount());
+}
+
 void CJoystick::SetName(const std::string& strName)
 {
   std::string strSanitizedFilename = kodi::tools::StringUtils::MakeSafeString(strName);
@@ -61,9 +131,15 @@ bool CJoystick::Initialize(void)
   m_state.hats.assign(HatCount(), JOYSTICK_STATE_HAT_UNPRESSED);
   m_state.axes.resize(AxisCount());
 
-  m_stateBuffer.buttons.assign(ButtonCount(), JOYSTICK_STATE_BUTTON_UNPRESSED);
-  m_stateBuffer.hats.assign(HatCount(), JOYSTICK_STATE_HAT_UNPRESSED);
-  m_stateBuffer.axes.resize(AxisCount());
+  if (AxisCount() > 0)
+    GetAxisProperties(AxisCount() - 1);
+
+  ResizeMask(m_state.dirty.buttons, ButtonCount());
+  ResizeMask(m_state.dirty.hats, HatCount());
+
+  m_stateBuffer = m_state;
+  m_publishedDirty = m_state.dirty;
+  m_exchange.Reset(m_state);
 
   return true;
 }
@@ -77,20 +153,149 @@ void CJoystick::Deinitialize(void)
   m_stateBuffer.buttons.clear();
   m_stateBuffer.hats.clear();
   m_stateBuffer.axes.clear();
+
+  m_exchange.Reset(m_stateBuffer);
 }
 
-bool CJoystick::GetEvents(std::vector<kodi::addon::PeripheralEvent>& events)
+bool CJoystick::GetEvents(JoystickEventVector& events)
 {
-  if (ScanEvents())
+  if (!PollEvents())
+    return false;
+
+  // Nothing can have changed unless the driver published a new snapshot
+  if (m_exchange.Acquire())
   {
-    GetButtonEvents(events);
-    GetHatEvents(events);
-    GetAxisEvents(events);
+    const size_t eventCount = events.size();
 
-    return true;
+    GetButtonEvents(m_exchange.Front(), events);
+    GetHatEvents(m_exchange.Front(), events);
+    GetAxisEvents(m_exchange.Front(), events);
+
+    if (events.size() != eventCount)
+      RecordDelivery(m_exchange.Front().decodeTimeUs);
   }
 
-  return false;
+  return true;
+}
+
+void CJoystick::AttachStateTable(CJoystickStateTable& table, unsigned int slot)
+{
+  const JoystickState& state = m_exchange.Front();
+
+  // The latest snapshot may not have been reported yet
+  uint8_t* buttons = table.Buttons().Current(slot);
+  uint8_t* reportedButtons = table.Buttons().Previous(slot);
+  for (unsigned int i = 0; i < state.buttons.size(); i++)
+  {
+    buttons[i] = static_cast<uint8_t>(state.buttons[i]);
+    reportedButtons[i] = static_cast<uint8_t>(m_state.buttons[i]);
+  }
+
+  uint8_t* hats = table.Hats().Current(slot);
+  uint8_t* reportedHats = table.Hats().Previous(slot);
+  for (unsigned int i = 0; i < state.hats.size(); i++)
+  {
+    hats[i] = static_cast<uint8_t>(state.hats[i]);
+    reportedHats[i] = static_cast<uint8_t>(m_state.hats[i]);
+  }
+
+  // Reported axis values have the deadzone applied, so leave the previous
+  // values unseen to check every axis on the next frame
+  float* axes = table.Axes().Current(slot);
+  for (unsigned int i = 0; i < state.axes.size(); i++)
+    axes[i] = state.axes[i].bSeen ? state.axes[i].state : CJoystickStateTable::UNSEEN_AXIS;
+
+  m_acquiredDecodeTimeUs = state.decodeTimeUs;
+}
+
+bool CJoystick::UpdateStateTable(CJoystickStateTable& table, unsigned int slot)
+{
+  if (!PollEvents())
+    return false;
+
+  if (m_exchange.Acquire())
+  {
+    const JoystickState& state = m_exchange.Front();
+
+    uint8_t* buttons = table.Buttons().Current(slot);
+    ForEachDirty(state.dirty.buttons, [&state, buttons](unsigned int i)
+      {
+        buttons[i] = static_cast<uint8_t>(state.buttons[i]);
+      });
+
+    uint8_t* hats = table.Hats().Current(slot);
+    ForEachDirty(state.dirty.hats, [&state, hats](unsigned int i)
+      {
+        hats[i] = static_cast<uint8_t>(state.hats[i]);
+      });
+
+    float* axes = table.Axes().Current(slot);
+    for (unsigned int i = 0; i < state.axes.size(); i++)
+    {
+      if (state.axes[i].bSeen)
+        axes[i] = state.axes[i].state;
+    }
+
+    m_acquiredDecodeTimeUs = state.decodeTimeUs;
+  }
+
+  return true;
+}
+
+void CJoystick::GetEvents(const CJoystickStateTable& table, unsigned int slot, JoystickEventVector& events)
+{
+  const size_t eventCount = events.size();
+
+  const uint8_t* buttons = table.Buttons().Current(slot);
+  ForEachDirty(table.Buttons().Changes(slot), table.Buttons().WordCount(slot), [this, buttons, &events](unsigned int i)
+    {
+      m_state.buttons[i] = static_cast<JOYSTICK_STATE_BUTTON>(buttons[i]);
+      events.push_back(JoystickEvent::Button(Index(), i, m_state.buttons[i]));
+    });
+
+  const uint8_t* hats = table.Hats().Current(slot);
+  ForEachDirty(table.Hats().Changes(slot), table.Hats().WordCount(slot), [this, hats, &events](unsigned int i)
+    {
+      m_state.hats[i] = static_cast<JOYSTICK_STATE_HAT>(hats[i]);
+      events.push_back(JoystickEvent::Hat(Index(), i, m_state.hats[i]));
+    });
+
+  const float* axes = table.Axes().Current(slot);
+  const float deadzone = CSettings::Get().AnalogDeadzone();
+
+  auto getAxisEvent = [this, axes, deadzone, &events](unsigned int i)
+    {
+      if (std::isnan(axes[i]))
+        return;
+
+      const int stickAxis = m_axisProperties[i].stickAxis;
+      const bool bStick = (stickAxis >= 0 && stickAxis < static_cast<int>(m_state.axes.size()));
+      const float stickValue = (bStick && !std::isnan(axes[stickAxis])) ? axes[stickAxis] : 0.0f;
+
+      GetAxisEvent(i, axes[i], stickValue, deadzone, events);
+    };
+
+  ForEachDirty(table.Axes().Changes(slot), table.Axes().WordCount(slot), [this, deadzone, &getAxisEvent](unsigned int i)
+    {
+      getAxisEvent(i);
+
+      // Moving one axis of a stick rescales the other inside the deadzone
+      const int stickAxis = m_axisProperties[i].stickAxis;
+      if (deadzone > 0.0f && stickAxis >= 0 && stickAxis < static_cast<int>(m_state.axes.size()))
+        getAxisEvent(stickAxis);
+    });
+
+  if (events.size() != eventCount)
+    RecordDelivery(m_acquiredDecodeTimeUs);
+}
+
+bool CJoystick::ReadEvents(void)
+{
+  std::lock_guard<std::mutex> lock(m_readMutex);
+
+  ScanEvents();
+
+  return PublishState();
 }
 
 bool CJoystick::SendEvent(const kodi::addon::PeripheralEvent& event)
@@ -111,12 +316,66 @@ bool CJoystick::SendEvent(const kodi::addon::PeripheralEvent& event)
   return bHandled;
 }
 
-void CJoystick::Activate()
+bool CJoystick::PollEvents(void)
+{
+  // Input has already been read if the joystick is driven by the reactor
+  if (m_bReactorDriven)
+    return true;
+
+  std::lock_guard<std::mutex> lock(m_readMutex);
+
+  if (!ScanEvents())
+    return false;
+
+  PublishState();
+
+  return true;
+}
+
+void CJoystick::SetInputTime(int64_t inputTimeUs)
+{
+  const int64_t nowUs = GetMonotonicTimeUs();
+
+  // A time in the future means the driver isn't using our clock
+  if (inputTimeUs <= nowUs)
+    m_inputLatency.Record(nowUs - inputTimeUs);
+}
+
+void CJoystick::SetStateChanged()
 {
-  if (!IsActive())
+  if (!m_bStateChanged)
   {
-    m_isActive = true;
+    m_stateBuffer.decodeTimeUs = GetMonotonicTimeUs();
+    m_bStateChanged = true;
+  }
+}
+
+void CJoystick::RecordDelivery(int64_t decodeTimeUs)
+{
+  const int64_t nowUs = GetMonotonicTimeUs();
 
+  m_deliveryLatency.Record(nowUs - decodeTimeUs);
+
+  if (m_lastLatencyLogUs == 0)
+  {
+    m_lastLatencyLogUs = nowUs;
+  }
+  else if (nowUs - m_lastLatencyLogUs >= LATENCY_LOG_INTERVAL_US)
+  {
+    dsyslog("Joystick %u latency: input->decode %s, decode->delivery %s",
+            Index(), m_inputLatency.ToString().c_str(), m_deliveryLatency.ToString().c_str());
+
+    m_inputLatency.Reset();
+    m_deliveryLatency.Reset();
+    m_lastLatencyLogUs = nowUs;
+  }
+}
+
+void CJoystick::Activate()
+{
+  // Only the first input can trigger a scan
+  if (!m_isActive.exchange(true))
+  {
     if (CJoystickUtils::IsGhostJoystick(*this))
     {
       CJoystickManager::Get().SetChanged(true);
@@ -125,59 +384,139 @@ void CJoystick::Activate()
   }
 }
 
-void CJoystick::GetButtonEvents(std::vector<kodi::addon::PeripheralEvent>& events)
+bool CJoystick::PublishState(void)
 {
-  const std::vector<JOYSTICK_STATE_BUTTON>& buttons = m_stateBuffer.buttons;
+  if (!m_bStateChanged)
+    return false;
+
+  // Sizes never change after Initialize(), so this doesn't allocate
+  JoystickState& snapshot = m_exchange.Back();
+  std::copy(m_stateBuffer.buttons.begin(), m_stateBuffer.buttons.end(), snapshot.buttons.begin());
+  std::copy(m_stateBuffer.hats.begin(), m_stateBuffer.hats.end(), snapshot.hats.begin());
+  std::copy(m_stateBuffer.axes.begin(), m_stateBuffer.axes.end(), snapshot.axes.begin());
+
+  // If the previous snapshot hasn't been acquired yet, the consumer will skip
+  // it, so its changes must be carried into this one
+  const bool bCarry = m_exchange.IsPending();
+
+  snapshot.decodeTimeUs = bCarry ? m_publishedDecodeTimeUs : m_stateBuffer.decodeTimeUs;
+  m_publishedDecodeTimeUs = snapshot.decodeTimeUs;
 
-  for (unsigned int i = 0; i < buttons.size(); i++)
+  for (unsigned int i = 0; i < snapshot.dirty.buttons.size(); i++)
   {
-    if (buttons[i] != m_state.buttons[i])
-      events.push_back(kodi::addon::PeripheralEvent(Index(), i, buttons[i]));
+    snapshot.dirty.buttons[i] = m_stateBuffer.dirty.buttons[i] | (bCarry ? m_publishedDirty.buttons[i] : 0);
+    m_publishedDirty.buttons[i] = snapshot.dirty.buttons[i];
+    m_stateBuffer.dirty.buttons[i] = 0;
   }
 
-  m_state.buttons.assign(buttons.begin(), buttons.end());
+  for (unsigned int i = 0; i < snapshot.dirty.hats.size(); i++)
+  {
+    snapshot.dirty.hats[i] = m_stateBuffer.dirty.hats[i] | (bCarry ? m_publishedDirty.hats[i] : 0);
+    m_publishedDirty.hats[i] = snapshot.dirty.hats[i];
+    m_stateBuffer.dirty.hats[i] = 0;
+  }
+
+  m_exchange.Publish();
+
+  m_bStateChanged = false;
+
+  return true;
+}
+
+void CJoystick::GetButtonEvents(const JoystickState& state, JoystickEventVector& events)
+{
+  ForEachDirty(state.dirty.buttons, [this, &state, &events](unsigned int i)
+    {
+      if (state.buttons[i] != m_state.buttons[i])
+      {
+        events.push_back(JoystickEvent::Button(Index(), i, state.buttons[i]));
+        m_state.buttons[i] = state.buttons[i];
+      }
+    });
+}
+
+void CJoystick::GetHatEvents(const JoystickState& state, JoystickEventVector& events)
+{
+  ForEachDirty(state.dirty.hats, [this, &state, &events](unsigned int i)
+    {
+      if (state.hats[i] != m_state.hats[i])
+      {
+        events.push_back(JoystickEvent::Hat(Index(), i, state.hats[i]));
+        m_state.hats[i] = state.hats[i];
+      }
+    });
 }
 
-void CJoystick::GetHatEvents(std::vector<kodi::addon::PeripheralEvent>& events)
+void CJoystick::GetAxisEvents(const JoystickState& state, JoystickEventVector& events)
 {
-  const std::vector<JOYSTICK_STATE_HAT>& hats = m_stateBuffer.hats;
+  const std::vector<JoystickAxis>& axes = state.axes;
+  const float deadzone = CSettings::Get().AnalogDeadzone();
 
-  for (unsigned int i = 0; i < hats.size(); i++)
+  for (unsigned int i = 0; i < axes.size(); i++)
   {
-    if (hats[i] != m_state.hats[i])
-      events.push_back(kodi::addon::PeripheralEvent(Index(), i, hats[i]));
-  }
+    if (!axes[i].bSeen)
+      continue;
+
+    const int stickAxis = m_axisProperties[i].stickAxis;
+    const float stickValue = (stickAxis >= 0 && stickAxis < static_cast<int>(axes.size())) ? axes[stickAxis].state : 0.0f;
 
-  m_state.hats.assign(hats.begin(), hats.end());
+    GetAxisEvent(i, axes[i].state, stickValue, deadzone, events);
+  }
 }
 
-void CJoystick::GetAxisEvents(std::vector<kodi::addon::PeripheralEvent>& events)
+void CJoystick::GetAxisEvent(unsigned int axisIndex, float value, float stickValue, float deadzone, JoystickEventVector& events)
 {
-  const std::vector<JoystickAxis>& axes = m_stateBuffer.axes;
+  const AxisProperties& properties = m_axisProperties[axisIndex];
 
-  for (unsigned int i = 0; i < axes.size(); i++)
+  // Apply radial deadzone to analog sticks, rescaling the remaining range
+  if (deadzone > 0.0f && properties.stickAxis >= 0 && properties.stickAxis < static_cast<int>(m_state.axes.size()))
   {
-    if (axes[i].bSeen)
-      events.push_back(kodi::addon::PeripheralEvent(Index(), i, axes[i].state));
+    const float magnitude = std::sqrt(value * value + stickValue * stickValue);
+
+    if (magnitude <= deadzone)
+      value = 0.0f;
+    else
+      value *= std::min((magnitude - deadzone) / (1.0f - deadzone), 1.0f) / magnitude;
   }
 
-  m_state.axes.assign(axes.begin(), axes.end());
+  JoystickAxis& reported = m_state.axes[axisIndex];
+
+  // Report the first value, changes larger than epsilon, and the exact
+  // center so that small moves back to rest aren't swallowed
+  const bool bChanged = !reported.bSeen ||
+                        std::abs(value - reported.state) > properties.epsilon ||
+                        (value == 0.0f && reported.state != 0.0f);
+
+  if (bChanged)
+  {
+    events.push_back(JoystickEvent::Axis(Index(), axisIndex, value));
+    reported.state = value;
+    reported.bSeen = true;
+  }
 }
 
 void CJoystick::SetButtonValue(unsigned int buttonIndex, JOYSTICK_STATE_BUTTON buttonValue)
 {
   Activate();
 
-  if (buttonIndex < m_stateBuffer.buttons.size())
+  if (buttonIndex < m_stateBuffer.buttons.size() && m_stateBuffer.buttons[buttonIndex] != buttonValue)
+  {
     m_stateBuffer.buttons[buttonIndex] = buttonValue;
+    SetDirty(m_stateBuffer.dirty.buttons, buttonIndex);
+    SetStateChanged();
+  }
 }
 
 void CJoystick::SetHatValue(unsigned int hatIndex, JOYSTICK_STATE_HAT hatValue)
 {
   Activate();
 
-  if (hatIndex < m_stateBuffer.hats.size())
+  if (hatIndex < m_stateBuffer.hats.size() && m_stateBuffer.hats[hatIndex] != hatValue)
+  {
     m_stateBuffer.hats[hatIndex] = hatValue;
+    SetDirty(m_stateBuffer.dirty.hats, hatIndex);
+    SetStateChanged();
+  }
 }
 
 void CJoystick::SetAxisValue(unsigned int axisIndex, JOYSTICK_STATE_AXIS axisValue)
@@ -188,11 +527,40 @@ void CJoystick::SetAxisValue(unsigned int axisIndex, JOYSTICK_STATE_AXIS axisVal
 
   if (axisIndex < m_stateBuffer.axes.size())
   {
-    m_stateBuffer.axes[axisIndex].state = axisValue;
-    m_stateBuffer.axes[axisIndex].bSeen = true;
+    JoystickAxis& axis = m_stateBuffer.axes[axisIndex];
+    if (!axis.bSeen || axis.state != axisValue)
+    {
+      axis.state = axisValue;
+      axis.bSeen = true;
+      SetStateChanged();
+    }
   }
 }
 
+void CJoystick::SetAxisEpsilon(unsigned int axisIndex, float epsilon)
+{
+  GetAxisProperties(axisIndex).epsilon = epsilon;
+}
+
+void CJoystick::SetAnalogStick(unsigned int xAxisIndex, unsigned int yAxisIndex)
+{
+  GetAxisProperties(xAxisIndex).stickAxis = yAxisIndex;
+  GetAxisProperties(yAxisIndex).stickAxis = xAxisIndex;
+}
+
+CJoystick::AxisProperties& CJoystick::GetAxisProperties(unsigned int axisIndex)
+{
+  if (axisIndex >= m_axisProperties.size())
+  {
+    AxisProperties defaultProperties;
+    defaultProperties.epsilon = ANALOG_EPSILON;
+
+    m_axisProperties.resize(axisIndex + 1, defaultProperties);
+  }
+
+  return m_axisProperties[axisIndex];
+}
+
 void CJoystick::SetAxisValue(unsigned int axisIndex, long value, long maxAxisAmount)
 {
   if (maxAxisAmount != 0)
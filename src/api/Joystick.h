@@ -8,15 +8,23 @@
 
 #pragma once
 
+#include "JoystickEvent.h"
 #include "JoystickTypes.h"
+#include "utils/LatencyHistogram.h"
+#include "utils/TripleBuffer.h"
 
 #include <kodi/addon-instance/Peripheral.h>
 
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
 #include <string>
 #include <vector>
 
 namespace JOYSTICK
 {
+  class CJoystickStateTable;
+
   class CJoystick : public kodi::addon::Joystick
   {
   public:
@@ -29,6 +37,16 @@ namespace JOYSTICK
      */
     virtual bool Equals(const CJoystick* rhs) const;
 
+    /*!
+     * Get a string that identifies the device behind this joystick
+     *
+     * Joysticks of the same interface with the same identity are treated as
+     * the same device, so scan results can be matched in constant time. By
+     * default it's built from the properties that Equals() compares.
+     * Interfaces that know the device node or path use that instead.
+     */
+    virtual std::string Identity(void) const;
+
     /*!
      * Override subclass to sanitize name (strip trailing whitespace, etc)
      */
@@ -54,7 +72,25 @@ namespace JOYSTICK
     /*!
      * Get events that have occurred since the last call to GetEvents()
      */
-    virtual bool GetEvents(std::vector<kodi::addon::PeripheralEvent>& events);
+    virtual bool GetEvents(JoystickEventVector& events);
+
+    /*!
+     * Copy the joystick's state into its slot of the state table. Called when
+     * the table is laid out.
+     */
+    void AttachStateTable(CJoystickStateTable& table, unsigned int slot);
+
+    /*!
+     * Copy input received since the last call into the joystick's slot of
+     * the state table
+     */
+    bool UpdateStateTable(CJoystickStateTable& table, unsigned int slot);
+
+    /*!
+     * Get events for the changes found in the joystick's slot by the last
+     * CJoystickStateTable::Diff()
+     */
+    void GetEvents(const CJoystickStateTable& table, unsigned int slot, JoystickEventVector& events);
 
     /*!
      * Send an event to a joystick
@@ -71,6 +107,33 @@ namespace JOYSTICK
      */
     virtual void PowerOff() { }
 
+    /*!
+     * Get a file descriptor that becomes readable when input is available, or
+     * -1 if the joystick can only be polled
+     */
+    virtual int GetPollFD(void) const { return -1; }
+
+    /*!
+     * Check if an axis rests at the minimum of its range, like a trigger,
+     * instead of at its center
+     */
+    virtual bool AxisRestsAtMinimum(unsigned int axisIndex) const { return false; }
+
+    /*!
+     * Read input from the driver. Called by the input reactor when the
+     * descriptor returned by GetPollFD() becomes readable.
+     *
+     * \return true if the input changed the joystick's state, so that the
+     *         next call to GetEvents() has something to report
+     */
+    bool ReadEvents(void);
+
+    /*!
+     * Set to true when input is read by the input reactor. GetEvents() will
+     * then only report the input that has already been read.
+     */
+    void SetReactorDriven(bool bReactorDriven) { m_bReactorDriven = bReactorDriven; }
+
   protected:
     /*!
      * Implemented by derived class to scan for events
@@ -84,12 +147,44 @@ namespace JOYSTICK
     virtual void SetAxisValue(unsigned int axisIndex, JOYSTICK_STATE_AXIS axisValue);
     void SetAxisValue(unsigned int axisIndex, long value, long maxAxisAmount);
 
+    /*!
+     * Set the smallest change in an axis's value that is reported as an event.
+     * Must be called before the joystick is initialized.
+     */
+    void SetAxisEpsilon(unsigned int axisIndex, float epsilon);
+
+    /*!
+     * Declare two axes as the X and Y axes of an analog stick. The radial
+     * deadzone from the add-on settings is applied to the pair. Must be
+     * called before the joystick is initialized.
+     */
+    void SetAnalogStick(unsigned int xAxisIndex, unsigned int yAxisIndex);
+
+    /*!
+     * Record the time at which the driver generated the input being scanned,
+     * in microseconds of GetMonotonicTimeUs(). Called from ScanEvents() by
+     * drivers that know when input was generated.
+     */
+    void SetInputTime(int64_t inputTimeUs);
+
+    /*!
+     * Scan for input and publish the joystick's state, unless input is read
+     * by the reactor. Overridden by drivers whose input arrives on another
+     * thread, to publish the state under the same lock that writes it.
+     */
+    virtual bool PollEvents(void);
+
   private:
     void Activate();
+    void SetStateChanged();
 
-    void GetButtonEvents(std::vector<kodi::addon::PeripheralEvent>& events);
-    void GetHatEvents(std::vector<kodi::addon::PeripheralEvent>& events);
-    void GetAxisEvents(std::vector<kodi::addon::PeripheralEvent>& events);
+    struct AxisProperties
+    {
+      float epsilon;
+      int   stickAxis = -1; // Other axis of the analog stick, or -1 if none
+    };
+
+    AxisProperties& GetAxisProperties(unsigned int axisIndex);
 
     struct JoystickAxis
     {
@@ -97,15 +192,54 @@ namespace JOYSTICK
       bool bSeen = false;
     };
 
+    /*!
+     * One bit per button and hat, set if the element changed
+     */
+    struct DirtyMask
+    {
+      std::vector<uint32_t> buttons;
+      std::vector<uint32_t> hats;
+    };
+
     struct JoystickState
     {
       std::vector<JOYSTICK_STATE_BUTTON> buttons;
       std::vector<JOYSTICK_STATE_HAT>    hats;
       std::vector<JoystickAxis>          axes;
+      DirtyMask                          dirty;
+      int64_t                            decodeTimeUs = 0; // Time of the oldest change since the last delivery
     };
 
-    JoystickState                     m_state;
+    bool PublishState(void);
+
+    void GetButtonEvents(const JoystickState& state, JoystickEventVector& events);
+    void GetHatEvents(const JoystickState& state, JoystickEventVector& events);
+    void GetAxisEvents(const JoystickState& state, JoystickEventVector& events);
+    void GetAxisEvent(unsigned int axisIndex, float value, float stickValue, float deadzone, JoystickEventVector& events);
+
+    void RecordDelivery(int64_t decodeTimeUs);
+
+    // State written by the driver, owned by the thread reading input
     JoystickState                     m_stateBuffer;
-    bool m_isActive = false;
+    bool                              m_bStateChanged = false;
+    DirtyMask                         m_publishedDirty; // Dirty mask of the last published snapshot
+    int64_t                           m_publishedDecodeTimeUs = 0;
+    std::mutex                        m_readMutex; // Only contended while switching to/from the reactor
+
+    // Snapshots of m_stateBuffer passed to the thread calling GetEvents()
+    CTripleBuffer<JoystickState>      m_exchange;
+
+    // Last state reported by GetEvents(), owned by the thread calling GetEvents()
+    JoystickState                     m_state;
+    std::vector<AxisProperties>       m_axisProperties;
+    int64_t                           m_acquiredDecodeTimeUs = 0; // Decode time of the state copied to the state table
+
+    // Input latency, logged and reset periodically by the thread calling GetEvents()
+    CLatencyHistogram                 m_inputLatency;    // Driver input time -> decode
+    CLatencyHistogram                 m_deliveryLatency; // Decode -> GetEvents()
+    int64_t                           m_lastLatencyLogUs = 0;
+
+    std::atomic<bool> m_isActive{false}; // Set by the thread reading input, read by scans
+    std::atomic<bool> m_bReactorDriven{false};
   };
 }
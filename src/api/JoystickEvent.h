@@ -0,0 +1,79 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <kodi/addon-instance/Peripheral.h>
+
+#include <stdint.h>
+#include <vector>
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Compact record of a driver event
+   *
+   * Events are collected in this form and only converted to
+   * kodi::addon::PeripheralEvent when they're handed to the frontend. Button
+   * and hat states are stored as their integer values.
+   */
+  struct JoystickEvent
+  {
+    uint32_t peripheralIndex;
+    uint16_t driverIndex;
+    uint8_t  type;     // PERIPHERAL_EVENT_TYPE
+    uint8_t  reserved;
+    float    value;
+
+    static JoystickEvent Button(unsigned int peripheralIndex, unsigned int buttonIndex, JOYSTICK_STATE_BUTTON state)
+    {
+      return Create(peripheralIndex, buttonIndex, PERIPHERAL_EVENT_TYPE_DRIVER_BUTTON, static_cast<float>(state));
+    }
+
+    static JoystickEvent Hat(unsigned int peripheralIndex, unsigned int hatIndex, JOYSTICK_STATE_HAT state)
+    {
+      return Create(peripheralIndex, hatIndex, PERIPHERAL_EVENT_TYPE_DRIVER_HAT, static_cast<float>(state));
+    }
+
+    static JoystickEvent Axis(unsigned int peripheralIndex, unsigned int axisIndex, JOYSTICK_STATE_AXIS state)
+    {
+      return Create(peripheralIndex, axisIndex, PERIPHERAL_EVENT_TYPE_DRIVER_AXIS, state);
+    }
+
+    kodi::addon::PeripheralEvent ToPeripheralEvent(void) const
+    {
+      switch (type)
+      {
+      case PERIPHERAL_EVENT_TYPE_DRIVER_BUTTON:
+        return kodi::addon::PeripheralEvent(peripheralIndex, driverIndex, static_cast<JOYSTICK_STATE_BUTTON>(static_cast<int>(value)));
+      case PERIPHERAL_EVENT_TYPE_DRIVER_HAT:
+        return kodi::addon::PeripheralEvent(peripheralIndex, driverIndex, static_cast<JOYSTICK_STATE_HAT>(static_cast<int>(value)));
+      case PERIPHERAL_EVENT_TYPE_DRIVER_AXIS:
+        return kodi::addon::PeripheralEvent(peripheralIndex, driverIndex, static_cast<JOYSTICK_STATE_AXIS>(value));
+      default:
+        break;
+      }
+
+      return kodi::addon::PeripheralEvent();
+    }
+
+  private:
+    static JoystickEvent Create(unsigned int peripheralIndex, unsigned int driverIndex, PERIPHERAL_EVENT_TYPE type, float value)
+    {
+      JoystickEvent event;
+      event.peripheralIndex = peripheralIndex;
+      event.driverIndex     = static_cast<uint16_t>(driverIndex);
+      event.type            = static_cast<uint8_t>(type);
+      event.reserved        = 0;
+      event.value           = value;
+      return event;
+    }
+  };
+
+  typedef std::vector<JoystickEvent> JoystickEventVector;
+}
@@ -30,6 +30,15 @@
 #if defined(HAVE_UDEV)
   #include "udev/JoystickInterfaceUdev.h"
 #endif
+#if defined(HAVE_REPLAY)
+  #include "replay/JoystickInterfaceReplay.h"
+#endif
+#if defined(HAVE_INPUT_RECORDER)
+  #include "replay/InputTraceRecorder.h"
+#endif
+#if defined(HAVE_EPOLL)
+  #include "JoystickReactor.h"
+#endif
 
 #include "log/Log.h"
 #include "settings/Settings.h"
@@ -37,28 +46,25 @@
 
 #include <algorithm>
 #include <iterator>
+#include <stdlib.h>
+#include <utility>
 
 using namespace JOYSTICK;
 
+// Initial capacity of the event arena. It grows to the largest frame seen.
+#define EVENT_ARENA_CAPACITY  256
+
 // --- Utility functions -------------------------------------------------------
 
 namespace JOYSTICK
 {
-  struct ScanResultEqual
+  /*!
+   * \brief Key used to index joysticks, unique across interfaces
+   */
+  std::string GetIdentity(const CJoystick& joystick)
   {
-    ScanResultEqual(const JoystickPtr& needle) : m_needle(needle) { }
-
-    bool operator()(const JoystickPtr& rhs)
-    {
-      if (m_needle)
-        return m_needle->Equals(rhs.get());
-
-      return m_needle == rhs;
-    }
-
-  private:
-    JoystickPtr const m_needle;
-  };
+    return joystick.Provider() + "/" + joystick.Identity();
+  }
 
   template <class T>
   void safe_delete(T*& pVal)
@@ -80,9 +86,14 @@ namespace JOYSTICK
 
 CJoystickManager::CJoystickManager(void)
   : m_scanner(NULL),
+    m_inputCallback(nullptr),
+    m_snapshot(std::make_shared<JoystickSnapshot>()),
+    m_reactor(nullptr),
     m_nextJoystickIndex(0),
-    m_bChanged(false)
+    m_bChanged(false),
+    m_bStateTableEnabled(false)
 {
+  m_eventArena.reserve(EVENT_ARENA_CAPACITY);
 }
 
 CJoystickManager& CJoystickManager::Get(void)
@@ -120,6 +131,11 @@ const std::vector<EJoystickInterface>& CJoystickManager::GetSupportedInterfaces(
 #if defined(HAVE_COCOA)
     supportedInterfaces.push_back(EJoystickInterface::COCOA);
 #endif
+
+  // Recorded input
+#if defined(HAVE_REPLAY)
+    supportedInterfaces.push_back(EJoystickInterface::REPLAY);
+#endif
   }
 
   return supportedInterfaces;
@@ -138,6 +154,9 @@ IJoystickInterface* CJoystickManager::CreateInterface(EJoystickInterface iface)
 #if defined(HAVE_LINUX_JOYSTICK)
   case EJoystickInterface::LINUX: return new CJoystickInterfaceLinux;
 #endif
+#if defined(HAVE_REPLAY)
+  case EJoystickInterface::REPLAY: return new CJoystickInterfaceReplay;
+#endif
 #if defined(HAVE_SDL_GAMEPAD)
   case EJoystickInterface::SDL: return new CJoystickInterfaceSDL;
 #endif
@@ -156,6 +175,7 @@ IJoystickInterface* CJoystickManager::CreateInterface(EJoystickInterface iface)
 
 bool CJoystickManager::Initialize(IScannerCallback* scanner)
 {
+  std::lock_guard<std::recursive_mutex> scanLock(m_scanMutex);
   std::lock_guard<std::recursive_mutex> lock(m_interfacesMutex);
 
   m_scanner = scanner;
@@ -172,23 +192,50 @@ bool CJoystickManager::Initialize(IScannerCallback* scanner)
   if (m_interfaces.empty())
     dsyslog("No joystick APIs in use");
 
+#if defined(HAVE_REPLAY)
+  // Replay has no setting, it's enabled in builds that include it
+  SetEnabled(EJoystickInterface::REPLAY, true);
+#endif
+
+#if defined(HAVE_INPUT_RECORDER)
+  // Record input to a trace for benchmarks and bug reports
+  const char* tracePath = getenv("JOYSTICK_RECORD_TRACE");
+  if (tracePath != nullptr && *tracePath != '\0')
+    CInputTraceRecorder::Get().Start(tracePath);
+#endif
+
   return true;
 }
 
 void CJoystickManager::Deinitialize(void)
 {
+  SetReactorEnabled(false);
+
+#if defined(HAVE_INPUT_RECORDER)
+  CInputTraceRecorder::Get().Stop();
+#endif
+
   {
+    std::lock_guard<std::recursive_mutex> interfacesLock(m_interfacesMutex);
     std::lock_guard<std::recursive_mutex> lock(m_joystickMutex);
-    m_joysticks.clear();
+    Publish(JoystickVector(), JoystickMap());
   }
 
+  // GetEvents() isn't called after deinitialization, so release the
+  // joysticks laid out in the state table here
+  m_stateTable.Clear();
+  m_stateTableSnapshot.reset();
+
   {
+    std::lock_guard<std::recursive_mutex> scanLock(m_scanMutex);
     std::lock_guard<std::recursive_mutex> lock(m_interfacesMutex);
     for (auto pInterface : m_interfaces)
       SetEnabled(pInterface->Type(), false);
     safe_delete_vector(m_interfaces);
   }
 
+  SetInputCallback(nullptr);
+
   m_scanner = NULL;
 }
 
@@ -230,6 +277,7 @@ bool CJoystickManager::HasInterface(EJoystickInterface iface) const
 
 void CJoystickManager::SetEnabled(EJoystickInterface iface, bool bEnabled)
 {
+  std::lock_guard<std::recursive_mutex> scanLock(m_scanMutex);
   std::lock_guard<std::recursive_mutex> lock(m_interfacesMutex);
 
   for (auto pInterface : m_interfaces)
@@ -265,44 +313,167 @@ bool CJoystickManager::IsEnabled(IJoystickInterface* iface)
   return m_enabledInterfaces.find(iface) != m_enabledInterfaces.end();
 }
 
+#if defined(HAVE_EPOLL)
+void CJoystickManager::SetReactorEnabled(bool bEnabled)
+{
+  std::lock_guard<std::recursive_mutex> lock(m_joystickMutex);
+
+  if (bEnabled && m_reactor == nullptr)
+  {
+    isyslog("Starting input reactor");
+
+    m_reactor = new CJoystickReactor;
+    if (!m_reactor->Initialize())
+    {
+      esyslog("Failed to start input reactor, falling back to polling");
+      SAFE_DELETE(m_reactor);
+      return;
+    }
+
+    for (const JoystickPtr& joystick : GetSnapshot()->joysticks)
+      m_reactor->RegisterJoystick(joystick);
+  }
+  else if (!bEnabled && m_reactor != nullptr)
+  {
+    isyslog("Stopping input reactor");
+
+    // Deinitializing returns all joysticks to polling
+    SAFE_DELETE(m_reactor);
+  }
+}
+#else
+void CJoystickManager::SetReactorEnabled(bool)
+{
+}
+#endif
+
+void CJoystickManager::SetInputCallback(IInputCallback* callback)
+{
+  std::lock_guard<std::mutex> lock(m_inputCallbackMutex);
+  m_inputCallback = callback;
+}
+
+void CJoystickManager::NotifyInput(void)
+{
+  std::lock_guard<std::mutex> lock(m_inputCallbackMutex);
+  if (m_inputCallback)
+    m_inputCallback->OnInputReady();
+}
+
 bool CJoystickManager::PerformJoystickScan(JoystickVector& joysticks)
 {
-  JoystickVector scanResults;
+  // Interfaces can't be disabled, and their hotplug handling doesn't run,
+  // until the scan is done. The interface lock is only taken to publish the
+  // result, so the frontend's queries never wait for the scan.
+  std::lock_guard<std::recursive_mutex> scanLock(m_scanMutex);
+
+  std::vector<IJoystickInterface*> interfaces;
+  JoystickSnapshotPtr snapshot;
   {
-    std::lock_guard<std::recursive_mutex> lock(m_interfacesMutex);
-    // Scan for joysticks (this can take a while, don't block)
-    for (auto pInterface : m_enabledInterfaces)
-      pInterface->ScanForJoysticks(scanResults);
+    std::lock_guard<std::recursive_mutex> interfacesLock(m_interfacesMutex);
+    interfaces.assign(m_enabledInterfaces.begin(), m_enabledInterfaces.end());
+    snapshot = GetSnapshot();
   }
 
-  std::lock_guard<std::recursive_mutex> lock(m_joystickMutex);
+  JoystickVector scanResults;
+
+  // Scan for joysticks (this can take a while, don't block)
+  for (auto pInterface : interfaces)
+    pInterface->ScanForJoysticks(scanResults);
+
+  // Joysticks found by the scan, with the new ones initialized
+  JoystickMap newIdentities;
+  std::vector<JoystickMap::value_type*> found; // In scan order
+
+  newIdentities.reserve(scanResults.size());
+  found.reserve(scanResults.size());
 
-  // Unregister removed joysticks
-  for (int i = (int)m_joysticks.size() - 1; i >= 0; i--)
+  for (const JoystickPtr& result : scanResults)
   {
-    if (std::find_if(scanResults.begin(), scanResults.end(), ScanResultEqual(m_joysticks.at(i))) == scanResults.end())
-      m_joysticks.erase(m_joysticks.begin() + i);
+    std::string identity = GetIdentity(*result);
+
+    // Skip duplicate scan results
+    if (newIdentities.find(identity) != newIdentities.end())
+      continue;
+
+    if (snapshot->identities.find(identity) == snapshot->identities.end())
+    {
+      if (!InitializeJoystick(result))
+        continue;
+    }
+
+    found.push_back(&*newIdentities.emplace(std::move(identity), result).first);
   }
 
-  // Register new joysticks
-  for (JoystickVector::iterator itJoystick = scanResults.begin(); itJoystick != scanResults.end(); ++itJoystick)
+  std::lock_guard<std::recursive_mutex> interfacesLock(m_interfacesMutex);
+
+  // Joysticks may have been added or removed since the scan started
+  const JoystickSnapshotPtr current = GetSnapshot();
+
+  JoystickVector newJoysticks;
+  JoystickVector added;
+
+  newJoysticks.reserve(found.size());
+
+  for (JoystickMap::value_type* entry : found)
   {
-    if (std::find_if(m_joysticks.begin(), m_joysticks.end(), ScanResultEqual(*itJoystick)) == m_joysticks.end())
+    auto itCurrent = current->identities.find(entry->first);
+    if (itCurrent != current->identities.end())
     {
-      if ((*itJoystick)->Initialize())
-      {
-        (*itJoystick)->SetIndex(m_nextJoystickIndex++);
+      entry->second = itCurrent->second;
+    }
+    else if (snapshot->identities.find(entry->first) != snapshot->identities.end())
+    {
+      // Removed since the scan started
+      newIdentities.erase(newIdentities.find(entry->first));
+      continue;
+    }
+    else
+    {
+      added.push_back(entry->second);
+    }
 
-        isyslog("Initialized joystick %u: \"%s\", axes: %u, hats: %u, buttons: %u",
-                (*itJoystick)->Index(), (*itJoystick)->Name().c_str(),
-                (*itJoystick)->AxisCount(), (*itJoystick)->HatCount(), (*itJoystick)->ButtonCount());
+    newJoysticks.push_back(entry->second);
+  }
 
-        m_joysticks.push_back(*itJoystick);
-      }
+  // Keep joysticks added since the scan started, which it may have missed
+  for (const auto& it : current->identities)
+  {
+    if (snapshot->identities.find(it.first) == snapshot->identities.end() &&
+        newIdentities.find(it.first) == newIdentities.end())
+    {
+      newJoysticks.push_back(it.second);
+      newIdentities.emplace(it.first, it.second);
     }
   }
 
-  joysticks = m_joysticks;
+  JoystickVector removed;
+  for (const auto& it : current->identities)
+  {
+    if (newIdentities.find(it.first) == newIdentities.end())
+      removed.push_back(it.second);
+  }
+
+  {
+    std::lock_guard<std::recursive_mutex> lock(m_joystickMutex);
+
+    joysticks = newJoysticks;
+
+    // Keep the current snapshot (and the state table laid out for it) if
+    // the scan found the same joysticks
+    if (!added.empty() || !removed.empty())
+      Publish(std::move(newJoysticks), std::move(newIdentities));
+
+#if defined(HAVE_EPOLL)
+    if (m_reactor)
+    {
+      for (const JoystickPtr& joystick : removed)
+        m_reactor->UnregisterJoystick(joystick);
+      for (const JoystickPtr& joystick : added)
+        m_reactor->RegisterJoystick(joystick);
+    }
+#endif
+  }
 
   // Work around bug on linux: Don't return disconnected Xbox 360 controllers
   joysticks.erase(std::remove_if(joysticks.begin(), joysticks.end(),
@@ -315,16 +486,117 @@ bool CJoystickManager::PerformJoystickScan(JoystickVector& joysticks)
   return true;
 }
 
-JoystickPtr CJoystickManager::GetJoystick(unsigned int index) const
+bool CJoystickManager::AddJoystick(const JoystickPtr& joystick)
 {
-  std::lock_guard<std::recursive_mutex> lock(m_joystickMutex);
+  std::lock_guard<std::recursive_mutex> interfacesLock(m_interfacesMutex);
+
+  const JoystickSnapshotPtr snapshot = GetSnapshot();
+
+  std::string identity = GetIdentity(*joystick);
+
+  if (snapshot->identities.find(identity) != snapshot->identities.end())
+    return false;
+
+  if (!InitializeJoystick(joystick))
+    return false;
 
-  for (JoystickVector::const_iterator it = m_joysticks.begin(); it != m_joysticks.end(); ++it)
   {
-    if ((*it)->Index() == index)
-      return *it;
+    std::lock_guard<std::recursive_mutex> lock(m_joystickMutex);
+
+    JoystickVector joysticks = snapshot->joysticks;
+    JoystickMap identities = snapshot->identities;
+
+    joysticks.push_back(joystick);
+    identities.emplace(std::move(identity), joystick);
+
+    Publish(std::move(joysticks), std::move(identities));
+
+#if defined(HAVE_EPOLL)
+    if (m_reactor)
+      m_reactor->RegisterJoystick(joystick);
+#endif
   }
 
+  // Let the frontend pick up the new joystick
+  SetChanged(true);
+  TriggerScan();
+
+  return true;
+}
+
+void CJoystickManager::RemoveJoystick(const JoystickPtr& joystick)
+{
+  std::lock_guard<std::recursive_mutex> interfacesLock(m_interfacesMutex);
+
+  const JoystickSnapshotPtr snapshot = GetSnapshot();
+
+  const std::string identity = GetIdentity(*joystick);
+
+  auto itIdentity = snapshot->identities.find(identity);
+  if (itIdentity == snapshot->identities.end())
+    return;
+
+  const JoystickPtr removed = itIdentity->second;
+
+  isyslog("Removed joystick %u: \"%s\"", removed->Index(), removed->Name().c_str());
+
+  {
+    std::lock_guard<std::recursive_mutex> lock(m_joystickMutex);
+
+    JoystickVector joysticks = snapshot->joysticks;
+    JoystickMap identities = snapshot->identities;
+
+    joysticks.erase(std::find(joysticks.begin(), joysticks.end(), removed));
+    identities.erase(identity);
+
+    Publish(std::move(joysticks), std::move(identities));
+
+#if defined(HAVE_EPOLL)
+    if (m_reactor)
+      m_reactor->UnregisterJoystick(removed);
+#endif
+  }
+
+  SetChanged(true);
+  TriggerScan();
+}
+
+bool CJoystickManager::InitializeJoystick(const JoystickPtr& joystick)
+{
+  if (!joystick->Initialize())
+    return false;
+
+  joystick->SetIndex(m_nextJoystickIndex++);
+
+  isyslog("Initialized joystick %u: \"%s\", axes: %u, hats: %u, buttons: %u",
+          joystick->Index(), joystick->Name().c_str(),
+          joystick->AxisCount(), joystick->HatCount(), joystick->ButtonCount());
+
+  return true;
+}
+
+void CJoystickManager::Publish(JoystickVector joysticks, JoystickMap identities)
+{
+  std::shared_ptr<JoystickSnapshot> snapshot = std::make_shared<JoystickSnapshot>();
+
+  snapshot->indexes.reserve(joysticks.size());
+  for (const JoystickPtr& joystick : joysticks)
+    snapshot->indexes.emplace(joystick->Index(), joystick);
+
+  snapshot->joysticks = std::move(joysticks);
+  snapshot->identities = std::move(identities);
+
+  std::atomic_store(&m_snapshot, JoystickSnapshotPtr(std::move(snapshot)));
+}
+
+JoystickPtr CJoystickManager::GetJoystick(unsigned int index) const
+{
+  const JoystickSnapshotPtr snapshot = GetSnapshot();
+
+  auto it = snapshot->indexes.find(index);
+  if (it != snapshot->indexes.end())
+    return it->second;
+
   return JoystickPtr();
 }
 
@@ -332,9 +604,9 @@ JoystickVector CJoystickManager::GetJoysticks(const kodi::addon::Joystick& joyst
 {
   JoystickVector result;
 
-  std::lock_guard<std::recursive_mutex> lock(m_joystickMutex);
+  const JoystickSnapshotPtr snapshot = GetSnapshot();
 
-  for (const auto& joystick : m_joysticks)
+  for (const auto& joystick : snapshot->joysticks)
   {
     if (joystick->Name() == joystickInfo.Name() &&
         joystick->Provider() == joystickInfo.Provider())
@@ -348,39 +620,93 @@ JoystickVector CJoystickManager::GetJoysticks(const kodi::addon::Joystick& joyst
 
 bool CJoystickManager::GetEvents(std::vector<kodi::addon::PeripheralEvent>& events)
 {
-  std::lock_guard<std::recursive_mutex> lock(m_joystickMutex);
+  m_eventArena.clear();
+
+  if (!GetEvents(m_eventArena))
+    return false;
+
+  events.reserve(events.size() + m_eventArena.size());
 
-  for (JoystickVector::iterator it = m_joysticks.begin(); it != m_joysticks.end(); ++it)
-    (*it)->GetEvents(events);
+  for (const JoystickEvent& event : m_eventArena)
+    events.emplace_back(event.ToPeripheralEvent());
 
   return true;
 }
 
-bool CJoystickManager::SendEvent(const kodi::addon::PeripheralEvent& event)
+bool CJoystickManager::GetEvents(JoystickEventVector& events)
 {
-  bool bHandled = false;
+  const JoystickSnapshotPtr snapshot = GetSnapshot();
 
-  std::lock_guard<std::recursive_mutex> lock(m_joystickMutex);
+  if (m_bStateTableEnabled)
+  {
+    GetStateTableEvents(snapshot, events);
+    return true;
+  }
 
-  for (const JoystickPtr& joystick : m_joysticks)
+  if (m_stateTableSnapshot)
   {
-    if (joystick->Index() == event.PeripheralIndex())
-    {
-      bHandled = joystick->SendEvent(event);
-      if (bHandled)
-        break;
-    }
+    m_stateTable.Clear();
+    m_stateTableSnapshot.reset();
+  }
+
+  for (const JoystickPtr& joystick : snapshot->joysticks)
+    joystick->GetEvents(events);
+
+  return true;
+}
+
+void CJoystickManager::GetStateTableEvents(const JoystickSnapshotPtr& snapshot, JoystickEventVector& events)
+{
+  const JoystickVector& joysticks = snapshot->joysticks;
+
+  // Snapshots are only replaced when joysticks are added or removed, so the
+  // table is only laid out again (and allocates) on hotplug
+  if (snapshot != m_stateTableSnapshot)
+  {
+    m_stateTable.Reset(joysticks);
+    for (unsigned int slot = 0; slot < joysticks.size(); slot++)
+      joysticks[slot]->AttachStateTable(m_stateTable, slot);
+
+    m_stateTableSnapshot = snapshot;
   }
 
-  return bHandled;
+  for (unsigned int slot = 0; slot < joysticks.size(); slot++)
+    joysticks[slot]->UpdateStateTable(m_stateTable, slot);
+
+  m_stateTable.Diff();
+
+  for (unsigned int slot = 0; slot < joysticks.size(); slot++)
+  {
+    if (m_stateTable.HasChanges(slot))
+      joysticks[slot]->GetEvents(m_stateTable, slot, events);
+  }
+}
+
+bool CJoystickManager::SendEvent(const kodi::addon::PeripheralEvent& event)
+{
+  JoystickPtr joystick = GetJoystick(event.PeripheralIndex());
+  if (!joystick)
+    return false;
+
+  return joystick->SendEvent(event);
 }
 
 void CJoystickManager::ProcessEvents()
 {
-  std::lock_guard<std::recursive_mutex> lock(m_joystickMutex);
+  const JoystickSnapshotPtr snapshot = GetSnapshot();
 
-  for (const JoystickPtr& joystick : m_joysticks)
+  for (const JoystickPtr& joystick : snapshot->joysticks)
     joystick->ProcessEvents();
+
+  // Don't wait for a scan in progress, which uses the interfaces. Hotplug
+  // events stay queued until the next frame.
+  std::unique_lock<std::recursive_mutex> scanLock(m_scanMutex, std::try_to_lock);
+  if (scanLock.owns_lock())
+  {
+    std::lock_guard<std::recursive_mutex> lock(m_interfacesMutex);
+    for (auto pInterface : m_enabledInterfaces)
+      pInterface->ProcessHotplug();
+  }
 }
 
 void CJoystickManager::SetChanged(bool bChanged)
@@ -8,17 +8,24 @@
 
 #pragma once
 
+#include "JoystickEvent.h"
+#include "JoystickStateTable.h"
 #include "JoystickTypes.h"
 #include "buttonmapper/ButtonMapTypes.h"
 
 #include <kodi/addon-instance/peripheral/PeripheralUtils.h>
 
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <set>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace JOYSTICK
 {
+  class CJoystickReactor;
   class IJoystickInterface;
 
   class IScannerCallback
@@ -32,6 +39,18 @@ namespace JOYSTICK
     virtual void TriggerScan(void) = 0;
   };
 
+  class IInputCallback
+  {
+  public:
+    virtual ~IInputCallback(void) { }
+
+    /*!
+     * \brief Called on the input reactor's thread when joysticks have new
+     *        input for GetEvents()
+     */
+    virtual void OnInputReady(void) = 0;
+  };
+
   class CJoystickManager
   {
   private:
@@ -93,6 +112,42 @@ namespace JOYSTICK
      */
     bool IsEnabled(IJoystickInterface* iface);
 
+    /*!
+     * \brief Read input on a dedicated thread instead of polling each joystick
+     *
+     * Only joysticks with a pollable file descriptor (udev and linux) are
+     * driven by the reactor. Other joysticks continue to be polled.
+     *
+     * \param bEnabled True to start the input reactor, false to stop it
+     */
+    void SetReactorEnabled(bool bEnabled);
+
+    /*!
+     * \brief Set the callback notified when input is ready
+     *
+     * Only joysticks read by the input reactor notify the callback. Other
+     * joysticks only read input when GetEvents() is called.
+     *
+     * \param callback The callback, or nullptr to stop notifications. Once
+     *        this returns, the previous callback won't be called again.
+     */
+    void SetInputCallback(IInputCallback* callback);
+
+    /*!
+     * \brief Notify the input callback that input is ready
+     */
+    void NotifyInput(void);
+
+    /*!
+     * \brief Detect changes of all joysticks in one pass over a shared state table
+     *
+     * Joysticks copy their input into contiguous arrays, which are compared
+     * against the previous frame at once instead of one joystick at a time.
+     *
+     * \param bEnabled True to use the state table, false to diff each joystick
+     */
+    void SetStateTableEnabled(bool bEnabled) { m_bStateTableEnabled = bEnabled; }
+
     /*!
      * \brief Scan the available interfaces for joysticks
      *
@@ -102,15 +157,36 @@ namespace JOYSTICK
      */
     bool PerformJoystickScan(JoystickVector& joysticks);
 
+    /*!
+     * \brief Add a single joystick reported by an interface's hotplug handling
+     *
+     * \return true if the joystick was initialized and added
+     */
+    bool AddJoystick(const JoystickPtr& joystick);
+
+    /*!
+     * \brief Remove a single joystick reported by an interface's hotplug handling
+     */
+    void RemoveJoystick(const JoystickPtr& joystick);
+
     JoystickPtr GetJoystick(unsigned int index) const;
 
     JoystickVector GetJoysticks(const kodi::addon::Joystick& joystickInfo) const;
 
     /*!
     * \brief Get all events that have occurred since the last call to GetEvents()
+    *
+    * Events are collected in a reusable arena and converted to Kodi's type
+    * with a single reservation.
     */
     bool GetEvents(std::vector<kodi::addon::PeripheralEvent>& events);
 
+    /*!
+     * \brief Append all events that have occurred since the last call to
+     *        GetEvents() in compact form
+     */
+    bool GetEvents(JoystickEventVector& events);
+
     /*!
      * \brief Send an event to a joystick
      *
@@ -145,14 +221,57 @@ namespace JOYSTICK
     const ButtonMap& GetButtonMap(const std::string& provider);
 
   private:
+    /*!
+     * \brief Initialize a joystick and assign its index
+     */
+    bool InitializeJoystick(const JoystickPtr& joystick);
+
+    typedef std::unordered_map<std::string, JoystickPtr> JoystickMap;
+
+    /*!
+     * \brief Immutable view of the joysticks, replaced as a whole on change
+     */
+    struct JoystickSnapshot
+    {
+      JoystickVector                                joysticks;
+      JoystickMap                                   identities; // Identity -> joystick
+      std::unordered_map<unsigned int, JoystickPtr> indexes;    // Peripheral index -> joystick
+    };
+
+    typedef std::shared_ptr<const JoystickSnapshot> JoystickSnapshotPtr;
+
+    /*!
+     * \brief Get the current snapshot. Never blocks on writers.
+     */
+    JoystickSnapshotPtr GetSnapshot(void) const { return std::atomic_load(&m_snapshot); }
+
+    /*!
+     * \brief Replace the current snapshot. Requires m_joystickMutex.
+     */
+    void Publish(JoystickVector joysticks, JoystickMap identities);
+
+    /*!
+     * \brief Get events through the state table, laying it out again if the
+     *        joysticks changed
+     */
+    void GetStateTableEvents(const JoystickSnapshotPtr& snapshot, JoystickEventVector& events);
+
     IScannerCallback*                m_scanner;
+    IInputCallback*                  m_inputCallback; // Guarded by m_inputCallbackMutex
     std::vector<IJoystickInterface*> m_interfaces;
     std::set<IJoystickInterface*>    m_enabledInterfaces;
-    JoystickVector                   m_joysticks;
-    unsigned int                     m_nextJoystickIndex;
+    JoystickSnapshotPtr              m_snapshot;
+    CJoystickReactor*                m_reactor;
+    std::atomic<unsigned int>        m_nextJoystickIndex; // Joysticks are initialized outside the locks
     bool                             m_bChanged;
+    JoystickEventVector              m_eventArena; // Only used by the thread calling GetEvents()
+    std::atomic<bool>                m_bStateTableEnabled;
+    CJoystickStateTable              m_stateTable; // Only used by the thread calling GetEvents()
+    JoystickSnapshotPtr              m_stateTableSnapshot; // Joysticks laid out in m_stateTable
+    std::mutex                       m_inputCallbackMutex;
     mutable std::recursive_mutex m_changedMutex;
+    mutable std::recursive_mutex m_scanMutex; // Held by scans and hotplug, and to enable interfaces. Taken before m_interfacesMutex.
     mutable std::recursive_mutex m_interfacesMutex;
-    mutable std::recursive_mutex m_joystickMutex;
+    mutable std::recursive_mutex m_joystickMutex; // Held by writers of m_snapshot and m_reactor, readers don't lock
   };
 }
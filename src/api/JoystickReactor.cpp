@@ -0,0 +1,213 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "JoystickReactor.h"
+#include "Joystick.h"
+#include "JoystickManager.h"
+#include "log/Log.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace JOYSTICK;
+
+#define INVALID_FD         (-1)
+#define MAX_EPOLL_EVENTS   16
+
+CJoystickReactor::CJoystickReactor(void) :
+  m_epollFd(INVALID_FD),
+  m_wakeFd(INVALID_FD),
+  m_bStop(false)
+{
+}
+
+bool CJoystickReactor::Initialize(void)
+{
+  m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+  if (m_epollFd < 0)
+  {
+    esyslog("[reactor]: Failed to create epoll set - %s", strerror(errno));
+    return false;
+  }
+
+  // Used to wake the reactor thread when it should exit
+  m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (m_wakeFd < 0)
+  {
+    esyslog("[reactor]: Failed to create wake descriptor - %s", strerror(errno));
+    Deinitialize();
+    return false;
+  }
+
+  epoll_event event = { };
+  event.events  = EPOLLIN;
+  event.data.fd = m_wakeFd;
+
+  if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &event) < 0)
+  {
+    esyslog("[reactor]: Failed to watch wake descriptor - %s", strerror(errno));
+    Deinitialize();
+    return false;
+  }
+
+  m_bStop = false;
+  m_thread = std::thread(&CJoystickReactor::Process, this);
+
+  return true;
+}
+
+void CJoystickReactor::Deinitialize(void)
+{
+  if (m_thread.joinable())
+  {
+    m_bStop = true;
+
+    const uint64_t wake = 1;
+    if (write(m_wakeFd, &wake, sizeof(wake)) < 0)
+      esyslog("[reactor]: Failed to wake reactor thread - %s", strerror(errno));
+
+    m_thread.join();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Return joysticks to polling
+    for (auto& it : m_joysticks)
+      it.second->SetReactorDriven(false);
+
+    m_joysticks.clear();
+  }
+
+  if (m_wakeFd >= 0)
+  {
+    close(m_wakeFd);
+    m_wakeFd = INVALID_FD;
+  }
+
+  if (m_epollFd >= 0)
+  {
+    close(m_epollFd);
+    m_epollFd = INVALID_FD;
+  }
+}
+
+bool CJoystickReactor::RegisterJoystick(const JoystickPtr& joystick)
+{
+  const int fd = joystick->GetPollFD();
+  if (fd < 0 || m_epollFd < 0)
+    return false;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  epoll_event event = { };
+  event.events  = EPOLLIN;
+  event.data.fd = fd;
+
+  if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) < 0)
+  {
+    esyslog("[reactor]: Failed to watch joystick \"%s\" - %s", joystick->Name().c_str(), strerror(errno));
+    return false;
+  }
+
+  m_joysticks[fd] = joystick;
+  joystick->SetReactorDriven(true);
+
+  return true;
+}
+
+void CJoystickReactor::UnregisterJoystick(const JoystickPtr& joystick)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  for (auto it = m_joysticks.begin(); it != m_joysticks.end(); ++it)
+  {
+    if (it->second == joystick)
+    {
+      RemoveDescriptor(it->first);
+      m_joysticks.erase(it);
+      break;
+    }
+  }
+
+  joystick->SetReactorDriven(false);
+}
+
+void CJoystickReactor::Process(void)
+{
+  epoll_event events[MAX_EPOLL_EVENTS];
+
+  while (!m_bStop)
+  {
+    const int count = epoll_wait(m_epollFd, events, MAX_EPOLL_EVENTS, -1);
+    if (count < 0)
+    {
+      if (errno == EINTR)
+        continue;
+
+      esyslog("[reactor]: Failed to wait for input - %s", strerror(errno));
+      break;
+    }
+
+    bool bInputReady = false;
+
+    for (int i = 0; i < count; i++)
+    {
+      const int fd = events[i].data.fd;
+
+      if (fd == m_wakeFd)
+        continue;
+
+      JoystickPtr joystick;
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_joysticks.find(fd);
+        if (it == m_joysticks.end())
+          continue;
+
+        joystick = it->second;
+
+        if (events[i].events & (EPOLLERR | EPOLLHUP))
+        {
+          // Device was disconnected. Keep the joystick reactor-driven so that
+          // it isn't polled until the next scan removes it.
+          RemoveDescriptor(fd);
+          m_joysticks.erase(it);
+          joystick.reset();
+        }
+      }
+
+      if (joystick)
+      {
+        // Read outside the lock, the joystick is kept alive by our reference
+        if (joystick->ReadEvents())
+          bInputReady = true;
+      }
+      else
+      {
+        CJoystickManager::Get().SetChanged(true);
+        CJoystickManager::Get().TriggerScan();
+      }
+    }
+
+    // Notify once for all joysticks that were read together
+    if (bInputReady)
+      CJoystickManager::Get().NotifyInput();
+  }
+}
+
+void CJoystickReactor::RemoveDescriptor(int fd)
+{
+  if (epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, nullptr) < 0)
+    dsyslog("[reactor]: Failed to stop watching descriptor %d - %s", fd, strerror(errno));
+}
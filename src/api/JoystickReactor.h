@@ -0,0 +1,68 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "JoystickTypes.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Reads input for joysticks that expose a pollable file descriptor
+   *
+   * A single thread waits on an epoll set containing the descriptor of every
+   * registered joystick. Input is read and decoded on that thread as soon as
+   * it arrives, so GetEvents() only has to collect the decoded state instead
+   * of issuing a read() per joystick per frame.
+   */
+  class CJoystickReactor
+  {
+  public:
+    CJoystickReactor(void);
+    ~CJoystickReactor(void) { Deinitialize(); }
+
+    /*!
+     * \brief Create the epoll set and start the reactor thread
+     */
+    bool Initialize(void);
+
+    /*!
+     * \brief Stop the reactor thread and return all joysticks to polling
+     */
+    void Deinitialize(void);
+
+    /*!
+     * \brief Start reading input for a joystick on the reactor thread
+     *
+     * \return true if the joystick is driven by the reactor, false if it
+     *         doesn't have a pollable descriptor and must be polled instead
+     */
+    bool RegisterJoystick(const JoystickPtr& joystick);
+
+    /*!
+     * \brief Stop reading input for a joystick on the reactor thread
+     */
+    void UnregisterJoystick(const JoystickPtr& joystick);
+
+  private:
+    void Process(void);
+    void RemoveDescriptor(int fd);
+
+    int                        m_epollFd;
+    int                        m_wakeFd;
+    std::atomic<bool>          m_bStop;
+    std::thread                m_thread;
+    std::map<int, JoystickPtr> m_joysticks; // Descriptor -> joystick
+    std::mutex                 m_mutex;
+  };
+}
@@ -0,0 +1,244 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "JoystickStateTable.h"
+#include "Joystick.h"
+
+#include <algorithm>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define STATE_TABLE_SSE2
+  #include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+  #define STATE_TABLE_NEON
+  #include <arm_neon.h>
+#endif
+
+using namespace JOYSTICK;
+
+#define CACHE_LINE_SIZE  64
+
+// Elements per word of the change mask
+#define ELEMENTS_PER_WORD  32
+
+constexpr float CJoystickStateTable::UNSEEN_AXIS;
+
+// --- Block comparison --------------------------------------------------------
+
+namespace
+{
+  /*!
+   * \brief Compare a block of 32 bytes and copy the changed parts
+   *
+   * \return A mask with bit i set if byte i changed
+   */
+  uint32_t DiffBlock(const uint8_t* current, uint8_t* previous)
+  {
+    uint32_t changes = 0;
+
+#if defined(STATE_TABLE_SSE2)
+    for (unsigned int i = 0; i < ELEMENTS_PER_WORD; i += 16)
+    {
+      const __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(current + i));
+      const __m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(previous + i));
+
+      const uint32_t changed = ~static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b))) & 0xffff;
+      if (changed != 0)
+      {
+        _mm_store_si128(reinterpret_cast<__m128i*>(previous + i), a);
+        changes |= changed << i;
+      }
+    }
+#elif defined(STATE_TABLE_NEON)
+    static const uint8_t bits[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    const uint8x16_t bitValues = vld1q_u8(bits);
+
+    for (unsigned int i = 0; i < ELEMENTS_PER_WORD; i += 16)
+    {
+      const uint8x16_t a = vld1q_u8(current + i);
+      const uint8x16_t b = vld1q_u8(previous + i);
+
+      const uint8x16_t changed = vmvnq_u8(vceqq_u8(a, b));
+      if (vmaxvq_u8(changed) != 0)
+      {
+        vst1q_u8(previous + i, a);
+
+        const uint8x16_t changedBits = vandq_u8(changed, bitValues);
+        const uint32_t low = vaddv_u8(vget_low_u8(changedBits));
+        const uint32_t high = vaddv_u8(vget_high_u8(changedBits));
+        changes |= (low | (high << 8)) << i;
+      }
+    }
+#else
+    for (unsigned int i = 0; i < ELEMENTS_PER_WORD; i += 8)
+    {
+      uint64_t a;
+      uint64_t b;
+      memcpy(&a, current + i, sizeof(a));
+      memcpy(&b, previous + i, sizeof(b));
+
+      if (a != b)
+      {
+        for (unsigned int j = i; j < i + 8; j++)
+        {
+          if (current[j] != previous[j])
+            changes |= 1u << j;
+        }
+        memcpy(previous + i, &a, sizeof(a));
+      }
+    }
+#endif
+
+    return changes;
+  }
+
+  /*!
+   * \brief Compare a block of 32 floats by their bit pattern and copy the
+   *        changed parts
+   *
+   * \return A mask with bit i set if float i changed
+   */
+  uint32_t DiffBlock(const float* current, float* previous)
+  {
+    uint32_t changes = 0;
+
+#if defined(STATE_TABLE_SSE2)
+    for (unsigned int i = 0; i < ELEMENTS_PER_WORD; i += 4)
+    {
+      const __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(current + i));
+      const __m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(previous + i));
+
+      const uint32_t changed = ~static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, b)))) & 0xf;
+      if (changed != 0)
+      {
+        _mm_store_si128(reinterpret_cast<__m128i*>(previous + i), a);
+        changes |= changed << i;
+      }
+    }
+#elif defined(STATE_TABLE_NEON)
+    static const uint32_t bits[4] = { 1, 2, 4, 8 };
+    const uint32x4_t bitValues = vld1q_u32(bits);
+
+    for (unsigned int i = 0; i < ELEMENTS_PER_WORD; i += 4)
+    {
+      const uint32x4_t a = vld1q_u32(reinterpret_cast<const uint32_t*>(current + i));
+      const uint32x4_t b = vld1q_u32(reinterpret_cast<const uint32_t*>(previous + i));
+
+      const uint32x4_t changed = vmvnq_u32(vceqq_u32(a, b));
+      if (vmaxvq_u32(changed) != 0)
+      {
+        vst1q_u32(reinterpret_cast<uint32_t*>(previous + i), a);
+        changes |= vaddvq_u32(vandq_u32(changed, bitValues)) << i;
+      }
+    }
+#else
+    for (unsigned int i = 0; i < ELEMENTS_PER_WORD; i++)
+    {
+      if (memcmp(current + i, previous + i, sizeof(float)) != 0)
+      {
+        previous[i] = current[i];
+        changes |= 1u << i;
+      }
+    }
+#endif
+
+    return changes;
+  }
+}
+
+// --- CStateColumn ------------------------------------------------------------
+
+template<typename T>
+void CStateColumn<T>::Reset(const std::vector<unsigned int>& counts, T value)
+{
+  m_offsets.resize(counts.size() + 1);
+
+  unsigned int elementCount = 0;
+  for (unsigned int slot = 0; slot < counts.size(); slot++)
+  {
+    m_offsets[slot] = elementCount;
+    elementCount += (counts[slot] + ELEMENTS_PER_WORD - 1) / ELEMENTS_PER_WORD * ELEMENTS_PER_WORD;
+  }
+  m_offsets[counts.size()] = elementCount;
+
+  // Both arrays start on a cache line
+  const size_t arraySize = (elementCount * sizeof(T) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+
+  m_storage.assign(2 * arraySize + CACHE_LINE_SIZE, 0);
+
+  uint8_t* data = m_storage.data();
+  data += (CACHE_LINE_SIZE - reinterpret_cast<uintptr_t>(data) % CACHE_LINE_SIZE) % CACHE_LINE_SIZE;
+
+  m_current = reinterpret_cast<T*>(data);
+  m_previous = reinterpret_cast<T*>(data + arraySize);
+
+  std::fill(m_current, m_current + elementCount, value);
+  std::fill(m_previous, m_previous + elementCount, value);
+
+  m_changes.assign(elementCount / ELEMENTS_PER_WORD, 0);
+}
+
+template<typename T>
+void CStateColumn<T>::Diff(void)
+{
+  for (unsigned int word = 0; word < m_changes.size(); word++)
+  {
+    const unsigned int offset = word * ELEMENTS_PER_WORD;
+    m_changes[word] = DiffBlock(m_current + offset, m_previous + offset);
+  }
+}
+
+namespace JOYSTICK
+{
+  template class CStateColumn<uint8_t>;
+  template class CStateColumn<float>;
+}
+
+// --- CJoystickStateTable -----------------------------------------------------
+
+void CJoystickStateTable::Reset(const JoystickVector& joysticks)
+{
+  std::vector<unsigned int> buttonCounts;
+  std::vector<unsigned int> hatCounts;
+  std::vector<unsigned int> axisCounts;
+
+  buttonCounts.reserve(joysticks.size());
+  hatCounts.reserve(joysticks.size());
+  axisCounts.reserve(joysticks.size());
+
+  for (const JoystickPtr& joystick : joysticks)
+  {
+    buttonCounts.push_back(joystick->ButtonCount());
+    hatCounts.push_back(joystick->HatCount());
+    axisCounts.push_back(joystick->AxisCount());
+  }
+
+  m_buttons.Reset(buttonCounts, JOYSTICK_STATE_BUTTON_UNPRESSED);
+  m_hats.Reset(hatCounts, JOYSTICK_STATE_HAT_UNPRESSED);
+  m_axes.Reset(axisCounts, UNSEEN_AXIS);
+}
+
+void CJoystickStateTable::Diff(void)
+{
+  m_buttons.Diff();
+  m_hats.Diff();
+  m_axes.Diff();
+}
+
+bool CJoystickStateTable::HasChanges(unsigned int slot) const
+{
+  auto hasChanges = [slot](const uint32_t* changes, unsigned int wordCount)
+    {
+      return std::any_of(changes, changes + wordCount, [](uint32_t word) { return word != 0; });
+    };
+
+  return hasChanges(m_buttons.Changes(slot), m_buttons.WordCount(slot)) ||
+         hasChanges(m_hats.Changes(slot), m_hats.WordCount(slot)) ||
+         hasChanges(m_axes.Changes(slot), m_axes.WordCount(slot));
+}
@@ -0,0 +1,111 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "JoystickTypes.h"
+
+#include <limits>
+#include <stdint.h>
+#include <vector>
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief One element type of the state table, for all joysticks
+   *
+   * Holds the current and previous value of every element in two contiguous,
+   * cache-aligned arrays. Each joystick's range starts on a 32-element
+   * boundary, so its change bits start on a word of the change mask.
+   */
+  template<typename T>
+  class CStateColumn
+  {
+  public:
+    /*!
+     * \brief Lay out a range of elements for each joystick. Both the current
+     *        and the previous values are set to the given value.
+     */
+    void Reset(const std::vector<unsigned int>& counts, T value);
+
+    T* Current(unsigned int slot) { return m_current + m_offsets[slot]; }
+    const T* Current(unsigned int slot) const { return m_current + m_offsets[slot]; }
+    T* Previous(unsigned int slot) { return m_previous + m_offsets[slot]; }
+
+    /*!
+     * \brief Bit i of the mask is set if element i changed in the last Diff()
+     */
+    const uint32_t* Changes(unsigned int slot) const { return m_changes.data() + m_offsets[slot] / 32; }
+
+    unsigned int WordCount(unsigned int slot) const { return (m_offsets[slot + 1] - m_offsets[slot]) / 32; }
+
+    /*!
+     * \brief Compare all current values against the previous values, then
+     *        make the current values the previous values
+     */
+    void Diff(void);
+
+  private:
+    std::vector<uint8_t>      m_storage;
+    T*                        m_current = nullptr;
+    T*                        m_previous = nullptr;
+    std::vector<unsigned int> m_offsets; // Index of each joystick's first element, plus the end
+    std::vector<uint32_t>     m_changes;
+  };
+
+  /*!
+   * \brief Input state of all joysticks in structure-of-arrays form
+   *
+   * Each joystick owns a slot in the table. Once per frame, the joysticks
+   * copy the input they've received into the table, and Diff() finds the
+   * changes of every joystick in one pass over contiguous memory, using SSE2
+   * or NEON where available.
+   *
+   * Axes are compared by their bit pattern. Axes that haven't been seen hold
+   * UNSEEN_AXIS.
+   *
+   * Only used by the thread calling GetEvents().
+   */
+  class CJoystickStateTable
+  {
+  public:
+    static constexpr float UNSEEN_AXIS = std::numeric_limits<float>::quiet_NaN();
+
+    /*!
+     * \brief Lay out a slot for each joystick, in order
+     */
+    void Reset(const JoystickVector& joysticks);
+
+    /*!
+     * \brief Remove all joysticks
+     */
+    void Clear(void) { Reset(JoystickVector()); }
+
+    CStateColumn<uint8_t>& Buttons(void) { return m_buttons; }
+    const CStateColumn<uint8_t>& Buttons(void) const { return m_buttons; }
+    CStateColumn<uint8_t>& Hats(void) { return m_hats; }
+    const CStateColumn<uint8_t>& Hats(void) const { return m_hats; }
+    CStateColumn<float>& Axes(void) { return m_axes; }
+    const CStateColumn<float>& Axes(void) const { return m_axes; }
+
+    /*!
+     * \brief Find the elements that changed since the last call
+     */
+    void Diff(void);
+
+    /*!
+     * \brief Check if any element of the joystick changed in the last Diff()
+     */
+    bool HasChanges(unsigned int slot) const;
+
+  private:
+    CStateColumn<uint8_t> m_buttons;
+    CStateColumn<uint8_t> m_hats;
+    CStateColumn<float>   m_axes;
+  };
+}
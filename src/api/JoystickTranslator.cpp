@@ -34,6 +34,10 @@ namespace JOYSTICK
       EJoystickInterface::LINUX,
       "linux",
     },
+    {
+      EJoystickInterface::REPLAY,
+      "replay",
+    },
     {
       EJoystickInterface::SDL,
       "sdl",
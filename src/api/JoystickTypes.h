@@ -24,6 +24,7 @@ namespace JOYSTICK
     COCOA,
     DIRECTINPUT,
     LINUX,
+    REPLAY,
     SDL,
     UDEV,
     XINPUT,
@@ -11,6 +11,7 @@
 #include "utils/CommonMacros.h"
 
 #include <assert.h>
+#include <stdint.h>
 
 using namespace JOYSTICK;
 
@@ -42,6 +43,11 @@ bool CJoystickCocoa::Equals(const CJoystick* rhs) const
   return joystick && m_device == joystick->m_device;
 }
 
+std::string CJoystickCocoa::Identity(void) const
+{
+  return std::to_string(reinterpret_cast<uintptr_t>(m_device));
+}
+
 bool CJoystickCocoa::Initialize(void)
 {
   std::lock_guard<std::recursive_mutex> lock(m_mutex);
@@ -130,7 +136,7 @@ void CJoystickCocoa::Deinitialize(void)
   m_bInitialized = false;
 }
 
-bool CJoystickCocoa::GetEvents(std::vector<kodi::addon::PeripheralEvent>& events)
+bool CJoystickCocoa::GetEvents(JoystickEventVector& events)
 {
   std::lock_guard<std::recursive_mutex> lock(m_mutex);
   return CJoystick::GetEvents(events);
@@ -142,6 +148,13 @@ bool CJoystickCocoa::ScanEvents(void)
   return m_bInitialized; // Events arrive asynchronously
 }
 
+bool CJoystickCocoa::PollEvents(void)
+{
+  // Input callbacks write the state under the same lock
+  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  return CJoystick::PollEvents();
+}
+
 void CJoystickCocoa::SetButtonValue(unsigned int buttonIndex, JOYSTICK_STATE_BUTTON buttonValue)
 {
   std::lock_guard<std::recursive_mutex> lock(m_mutex);
@@ -29,9 +29,10 @@ namespace JOYSTICK
 
     // implementation of CJoystick
     virtual bool Equals(const CJoystick* rhs) const override;
+    virtual std::string Identity(void) const override;
     virtual bool Initialize(void) override;
     virtual void Deinitialize(void) override;
-    virtual bool GetEvents(std::vector<kodi::addon::PeripheralEvent>& events) override;
+    virtual bool GetEvents(JoystickEventVector& events) override;
 
     // implementation of ICocoaInputCallback
     virtual void InputValueChanged(IOHIDValueRef value) override;
@@ -39,6 +40,7 @@ namespace JOYSTICK
   protected:
     // implementation of CJoystick
     virtual bool ScanEvents(void) override;
+    virtual bool PollEvents(void) override;
     virtual void SetButtonValue(unsigned int buttonIndex, JOYSTICK_STATE_BUTTON buttonValue) override;
     virtual void SetHatValue(unsigned int hatIndex, JOYSTICK_STATE_HAT hatValue) override;
     virtual void SetAxisValue(unsigned int axisIndex, JOYSTICK_STATE_AXIS axisValue) override;
@@ -13,6 +13,8 @@
 #include "utils/CommonMacros.h"
 #include "utils/windows/CharsetConverter.h"
 
+#include <stdio.h>
+
 using namespace JOYSTICK;
 
 #define AXIS_MIN     -32768  /* minimum value for axis coordinate */
@@ -58,6 +60,16 @@ bool CJoystickDirectInput::Equals(const CJoystick* rhs) const
   return m_deviceGuid == rhsDirectInput->m_deviceGuid;
 }
 
+std::string CJoystickDirectInput::Identity(void) const
+{
+  char guid[40];
+  snprintf(guid, sizeof(guid), "%08lX-%04X-%04X-%02X%02X-%02X%02X%02X%02X%02X%02X",
+           m_deviceGuid.Data1, m_deviceGuid.Data2, m_deviceGuid.Data3,
+           m_deviceGuid.Data4[0], m_deviceGuid.Data4[1], m_deviceGuid.Data4[2], m_deviceGuid.Data4[3],
+           m_deviceGuid.Data4[4], m_deviceGuid.Data4[5], m_deviceGuid.Data4[6], m_deviceGuid.Data4[7]);
+  return guid;
+}
+
 bool CJoystickDirectInput::Initialize(void)
 {
   HRESULT hr;
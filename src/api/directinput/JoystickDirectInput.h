@@ -25,6 +25,7 @@ namespace JOYSTICK
     virtual ~CJoystickDirectInput(void);
 
     virtual bool Equals(const CJoystick* rhs) const override;
+    virtual std::string Identity(void) const override;
 
     virtual bool Initialize(void) override;
 
@@ -56,45 +56,56 @@ bool CJoystickLinux::Equals(const CJoystick* rhs) const
 
 bool CJoystickLinux::ScanEvents(void)
 {
-  js_event joyEvent;
-
-  while (true)
+  do
   {
-    // Flush the driver queue
-    if (read(m_fd, &joyEvent, sizeof(joyEvent)) != sizeof(joyEvent))
+    // The circular driver queue holds 64 events. If compiling your own driver,
+    // you can increment this size bumping up JS_BUFF_SIZE in joystick.h
+    const int count = m_reader.Read(m_fd);
+    if (count < 0)
+    {
+      esyslog("%s: failed to read joystick \"%s\" on %s - %d (%s)",
+          __FUNCTION__, Name().c_str(), m_strFilename.c_str(), errno, strerror(errno));
+      break;
+    }
+
+    // Event times are in milliseconds of the kernel's jiffies clock. Traces
+    // are recorded in monotonic time, so the clock offset is estimated from
+    // the newest event of each batch.
+    if (count > 0)
+      m_clockOffset.Update(static_cast<int64_t>(m_reader.Event(count - 1).time) * 1000);
+
+    for (unsigned int i = 0; i < static_cast<unsigned int>(count); i++)
     {
-      if (errno == EAGAIN)
+      const js_event& joyEvent = m_reader.Event(i);
+
+      // The possible values of joystickEvent.type are:
+      // JS_EVENT_BUTTON    0x01    // button pressed/released
+      // JS_EVENT_AXIS      0x02    // joystick moved
+      // JS_EVENT_INIT      0x80    // (flag) initial state of device
+
+      const int64_t eventTimeUs = m_clockOffset.ToMonotonic(static_cast<int64_t>(joyEvent.time) * 1000);
+      m_traceSource.RecordJsEvent(*this, joyEvent.type, joyEvent.number, joyEvent.value, joyEvent.time, eventTimeUs);
+
+      // Ignore initial events, because they mess up the buttons
+      switch (joyEvent.type)
+      {
+      case JS_EVENT_BUTTON:
       {
-        // The circular driver queue holds 64 events. If compiling your own driver,
-        // you can increment this size bumping up JS_BUFF_SIZE in joystick.h
+        const JOYSTICK_STATE_BUTTON buttonValue = joyEvent.value ? JOYSTICK_STATE_BUTTON_PRESSED : JOYSTICK_STATE_BUTTON_UNPRESSED;
+        SetButtonValue(joyEvent.number, buttonValue);
         break;
       }
-      else
+      case JS_EVENT_AXIS:
       {
-        esyslog("%s: failed to read joystick \"%s\" on %s - %d (%s)",
-            __FUNCTION__, Name().c_str(), m_strFilename.c_str(), errno, strerror(errno));
+        const float axisValue = static_cast<float>(joyEvent.value) / MAX_AXIS;
+        SetAxisValue(joyEvent.number, axisValue);
+        break;
+      }
+      default:
         break;
       }
     }
-
-    // The possible values of joystickEvent.type are:
-    // JS_EVENT_BUTTON    0x01    // button pressed/released
-    // JS_EVENT_AXIS      0x02    // joystick moved
-    // JS_EVENT_INIT      0x80    // (flag) initial state of device
-
-    // Ignore initial events, because they mess up the buttons
-    switch (joyEvent.type)
-    {
-    case JS_EVENT_BUTTON:
-      SetButtonValue(joyEvent.number, (joyEvent.value ? JOYSTICK_STATE_BUTTON_PRESSED : JOYSTICK_STATE_BUTTON_UNPRESSED));
-      break;
-    case JS_EVENT_AXIS:
-      SetAxisValue(joyEvent.number, joyEvent.value, MAX_AXIS);
-      break;
-    default:
-      break;
-    }
-  }
+  } while (!m_reader.IsDrained());
 
   return true;
 }
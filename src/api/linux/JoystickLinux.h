@@ -8,7 +8,10 @@
 
 #pragma once
 
+#include "JoystickLinuxReader.h"
 #include "api/Joystick.h"
+#include "api/replay/InputTraceRecorder.h"
+#include "utils/ClockOffset.h"
 
 #include <stdint.h>
 #include <string>
@@ -24,12 +27,17 @@ namespace JOYSTICK
     // implementation of CJoystick
     virtual void Deinitialize(void) override;
     virtual bool Equals(const CJoystick* rhs) const override;
+    virtual std::string Identity(void) const override { return m_strFilename; }
+    virtual int GetPollFD(void) const override { return m_fd; }
 
   protected:
     virtual bool ScanEvents(void) override;
 
   private:
-    int         m_fd;
-    std::string m_strFilename;
+    int                  m_fd;
+    std::string          m_strFilename;
+    CJoystickLinuxReader m_reader;
+    CInputTraceSource    m_traceSource;
+    CClockOffset         m_clockOffset; // Converts event times for the trace
   };
 }
@@ -0,0 +1,101 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <array>
+#include <errno.h>
+#include <linux/joystick.h>
+#include <stdint.h>
+#include <unistd.h>
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Reads js_event records from a joystick device in batches
+   *
+   * Each call to Read() issues a single read() for up to a full driver queue
+   * of events. Axis updates that are superseded by a later update of the
+   * same axis in the batch are dropped, so only the final position is
+   * applied to the joystick state.
+   */
+  class CJoystickLinuxReader
+  {
+  public:
+    // Size of the circular driver queue (JS_BUFF_SIZE in the kernel)
+    static const unsigned int BATCH_SIZE = 64;
+
+    /*!
+     * \brief Read the next batch of events
+     *
+     * \return The number of events available through Event(), 0 if the queue
+     *         was empty, or -1 if the read failed (errno is set)
+     */
+    int Read(int fd)
+    {
+      m_bDrained = true;
+
+      const ssize_t len = read(fd, m_events.data(), sizeof(m_events));
+      if (len < 0)
+        return errno == EAGAIN ? 0 : -1;
+
+      const unsigned int count = static_cast<unsigned int>(len) / sizeof(js_event);
+
+      // A partial batch means the driver queue is empty, which saves the
+      // read() that would otherwise return EAGAIN
+      m_bDrained = (count < BATCH_SIZE);
+
+      return static_cast<int>(Coalesce(count));
+    }
+
+    /*!
+     * \brief True if the last read emptied the driver queue
+     */
+    bool IsDrained(void) const { return m_bDrained; }
+
+    const js_event& Event(unsigned int index) const { return m_events[index]; }
+
+  private:
+    unsigned int Coalesce(unsigned int count)
+    {
+      // Axis numbers are 8 bits
+      uint64_t seen[4] = { };
+      std::array<bool, BATCH_SIZE> keep;
+
+      // Walk backwards so the last update of each axis is the one kept
+      for (unsigned int i = count; i-- > 0; )
+      {
+        const js_event& event = m_events[i];
+
+        keep[i] = true;
+        if (event.type == JS_EVENT_AXIS)
+        {
+          uint64_t& word = seen[event.number / 64];
+          const uint64_t bit = static_cast<uint64_t>(1) << (event.number % 64);
+
+          if (word & bit)
+            keep[i] = false;
+          else
+            word |= bit;
+        }
+      }
+
+      unsigned int kept = 0;
+      for (unsigned int i = 0; i < count; i++)
+      {
+        if (keep[i])
+          m_events[kept++] = m_events[i];
+      }
+
+      return kept;
+    }
+
+    std::array<js_event, BATCH_SIZE> m_events;
+    bool                             m_bDrained = true;
+  };
+}
@@ -0,0 +1,211 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "InputTrace.h"
+#include "log/Log.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace JOYSTICK;
+
+namespace
+{
+  template<typename T>
+  bool GetEventTime(const TraceRecordHeader& header, int64_t& timestampUs)
+  {
+    if (header.size < sizeof(T))
+      return false;
+
+    timestampUs = reinterpret_cast<const T*>(&header)->timestampUs;
+    return true;
+  }
+
+  /*!
+   * \brief Get the timestamp of an event record of any type
+   *
+   * \return False if the record is too small for its type
+   */
+  bool GetEventTime(const TraceRecordHeader& header, int64_t& timestampUs)
+  {
+    switch (static_cast<ETraceRecord>(header.type))
+    {
+    case ETraceRecord::EVDEV_EVENT:
+      return GetEventTime<TraceEvdevEventRecord>(header, timestampUs);
+    case ETraceRecord::JS_EVENT:
+      return GetEventTime<TraceJsEventRecord>(header, timestampUs);
+    default:
+      return GetEventTime<TraceEventRecord>(header, timestampUs);
+    }
+  }
+}
+
+bool CInputTrace::Open(const std::string& path)
+{
+  Close();
+
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+  {
+    esyslog("Failed to open input trace %s - %s", path.c_str(), strerror(errno));
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) < 0 || st.st_size < static_cast<off_t>(sizeof(TraceFileHeader)))
+  {
+    esyslog("Input trace %s is empty or unreadable", path.c_str());
+    close(fd);
+    return false;
+  }
+
+  void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  // The mapping stays valid after the descriptor is closed
+  close(fd);
+
+  if (data == MAP_FAILED)
+  {
+    esyslog("Failed to map input trace %s - %s", path.c_str(), strerror(errno));
+    return false;
+  }
+
+  m_path = path;
+  m_data = static_cast<const uint8_t*>(data);
+  m_size = static_cast<size_t>(st.st_size);
+
+  if (!Index())
+  {
+    Close();
+    return false;
+  }
+
+  isyslog("Loaded input trace %s: %u devices, %.1fs", m_path.c_str(),
+      static_cast<unsigned int>(m_devices.size()), (m_endTimeUs - m_startTimeUs) / 1000000.0);
+
+  return true;
+}
+
+void CInputTrace::Close(void)
+{
+  if (m_data != nullptr)
+  {
+    munmap(const_cast<uint8_t*>(m_data), m_size);
+    m_data = nullptr;
+    m_size = 0;
+  }
+
+  m_devices.clear();
+  m_startTimeUs = 0;
+  m_endTimeUs = 0;
+}
+
+bool CInputTrace::Index(void)
+{
+  const TraceFileHeader* fileHeader = reinterpret_cast<const TraceFileHeader*>(m_data);
+  if (fileHeader->magic != INPUT_TRACE_MAGIC || fileHeader->version != INPUT_TRACE_VERSION)
+  {
+    esyslog("Input trace %s has an unsupported format", m_path.c_str());
+    return false;
+  }
+
+  bool bHasEvents = false;
+
+  size_t offset = sizeof(TraceFileHeader);
+  while (offset + sizeof(TraceRecordHeader) <= m_size)
+  {
+    const TraceRecordHeader* header = reinterpret_cast<const TraceRecordHeader*>(m_data + offset);
+
+    if (header->size < sizeof(TraceRecordHeader) ||
+        header->size % INPUT_TRACE_ALIGNMENT != 0 ||
+        offset + header->size > m_size)
+    {
+      // A recording that was cut short ends with a partial record
+      dsyslog("Input trace %s is truncated at offset %u", m_path.c_str(), static_cast<unsigned int>(offset));
+      break;
+    }
+
+    switch (static_cast<ETraceRecord>(header->type))
+    {
+    case ETraceRecord::DEVICE:
+    {
+      const TraceDeviceRecord* record = reinterpret_cast<const TraceDeviceRecord*>(header);
+      if (header->size < sizeof(TraceDeviceRecord) + record->nameLength + record->providerLength ||
+          header->device != m_devices.size())
+      {
+        esyslog("Input trace %s has an invalid device record", m_path.c_str());
+        return false;
+      }
+
+      const char* strings = reinterpret_cast<const char*>(record + 1);
+
+      TraceDevice device;
+      device.record = record;
+      device.name.assign(strings, record->nameLength);
+      device.provider.assign(strings + record->nameLength, record->providerLength);
+      m_devices.emplace_back(std::move(device));
+      break;
+    }
+    case ETraceRecord::EVDEV_KEY:
+    case ETraceRecord::EVDEV_ABS:
+    {
+      const size_t recordSize = (static_cast<ETraceRecord>(header->type) == ETraceRecord::EVDEV_KEY) ?
+          sizeof(TraceEvdevKeyRecord) : sizeof(TraceEvdevAbsRecord);
+
+      if (header->size < recordSize || header->device >= m_devices.size())
+      {
+        esyslog("Input trace %s has a layout for an unknown device", m_path.c_str());
+        return false;
+      }
+
+      TraceDevice& device = m_devices[header->device];
+      if (static_cast<ETraceRecord>(header->type) == ETraceRecord::EVDEV_KEY)
+        device.evdevKeys.push_back(reinterpret_cast<const TraceEvdevKeyRecord*>(header));
+      else
+        device.evdevAxes.push_back(reinterpret_cast<const TraceEvdevAbsRecord*>(header));
+      break;
+    }
+    case ETraceRecord::BUTTON:
+    case ETraceRecord::HAT:
+    case ETraceRecord::AXIS:
+    case ETraceRecord::EVDEV_EVENT:
+    case ETraceRecord::JS_EVENT:
+    {
+      TraceEvent event;
+      event.record = header;
+
+      if (!GetEventTime(*header, event.timestampUs) || header->device >= m_devices.size())
+      {
+        esyslog("Input trace %s has an event for an unknown device", m_path.c_str());
+        return false;
+      }
+
+      // Devices are recorded independently, so their events can interleave
+      // out of order
+      if (!bHasEvents || event.timestampUs < m_startTimeUs)
+        m_startTimeUs = event.timestampUs;
+      if (!bHasEvents || event.timestampUs > m_endTimeUs)
+        m_endTimeUs = event.timestampUs;
+      bHasEvents = true;
+
+      m_devices[header->device].events.push_back(event);
+      break;
+    }
+    default:
+      break;
+    }
+
+    offset += header->size;
+  }
+
+  return true;
+}
@@ -0,0 +1,206 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace JOYSTICK
+{
+  /*
+   * Input trace file format
+   *
+   * A trace is a TraceFileHeader followed by a sequence of records. Every
+   * record starts with a TraceRecordHeader holding the size of the whole
+   * record, so readers can skip record types they don't understand. Records
+   * are padded to a multiple of 8 bytes, which keeps every record aligned
+   * when the file is mapped into memory and read in place.
+   *
+   * Drivers record the events they read as-is, so a trace can be decoded
+   * again after the driver's decoding changes. Raw evdev events are preceded
+   * by their device's layout: the keycodes of its buttons and the ranges of
+   * its axes, in index order. Tools can also write decoded events.
+   *
+   * Timestamps are in microseconds of the monotonic clock, whichever clock the
+   * driver reports, so devices of all backends share one timeline.
+   *
+   * Fields are stored in host byte order. A trace recorded on a machine of
+   * different endianness is rejected because its magic doesn't match.
+   */
+
+  #define INPUT_TRACE_MAGIC      0x52544a4b // "KJTR"
+  #define INPUT_TRACE_VERSION    2
+  #define INPUT_TRACE_ALIGNMENT  8
+
+  enum class ETraceRecord : uint8_t
+  {
+    DEVICE      = 1, // A joystick appearing in the trace
+    BUTTON      = 2, // Decoded events
+    HAT         = 3,
+    AXIS        = 4,
+    EVDEV_KEY   = 5, // Keycode of an evdev device's button
+    EVDEV_ABS   = 6, // Range of an evdev device's axis
+    EVDEV_EVENT = 7, // input_event read from an evdev device
+    JS_EVENT    = 8, // js_event read from a Linux Joystick API device
+  };
+
+  struct TraceFileHeader
+  {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+  };
+
+  struct TraceRecordHeader
+  {
+    uint16_t size;   // Size of the record in bytes, including this header
+    uint8_t  type;   // ETraceRecord
+    uint8_t  device; // Index of the device, assigned by its DEVICE record
+  };
+
+  struct TraceDeviceRecord
+  {
+    TraceRecordHeader header;
+    uint16_t          buttonCount;
+    uint16_t          hatCount;
+    uint16_t          axisCount;
+    uint16_t          motorCount;
+    uint16_t          vendorId;
+    uint16_t          productId;
+    uint16_t          nameLength;     // Name follows the record
+    uint16_t          providerLength; // Provider follows the name
+    // Followed by the name and provider, not null-terminated
+  };
+
+  struct TraceEventRecord
+  {
+    TraceRecordHeader header;
+    uint16_t          index;       // Button, hat or axis index
+    uint16_t          reserved;
+    int64_t           timestampUs; // Time the driver generated the event, in GetMonotonicTimeUs()
+    float             value;       // Axis position, or the button or hat state
+    uint32_t          padding;
+  };
+
+  struct TraceEvdevKeyRecord
+  {
+    TraceRecordHeader header;
+    uint16_t          code;
+    uint16_t          reserved;
+  };
+
+  struct TraceEvdevAbsRecord
+  {
+    TraceRecordHeader header;
+    uint16_t          code;
+    uint16_t          reserved;
+    int32_t           minimum;     // Fields of the axis's input_absinfo
+    int32_t           maximum;
+    int32_t           fuzz;
+    int32_t           flat;
+  };
+
+  struct TraceEvdevEventRecord
+  {
+    TraceRecordHeader header;
+    uint16_t          type;        // Fields of the input_event
+    uint16_t          code;
+    int64_t           timestampUs; // The event's time, in GetMonotonicTimeUs()
+    int32_t           value;
+    uint32_t          padding;
+  };
+
+  struct TraceJsEventRecord
+  {
+    TraceRecordHeader header;
+    uint8_t           type;        // Fields of the js_event
+    uint8_t           number;
+    int16_t           value;
+    int64_t           timestampUs; // The event's time, in GetMonotonicTimeUs()
+    uint32_t          time;        // The event's time in milliseconds, as reported by the driver
+    uint32_t          padding;
+  };
+
+  static_assert(sizeof(TraceFileHeader) % INPUT_TRACE_ALIGNMENT == 0, "Invalid trace header size");
+  static_assert(sizeof(TraceEventRecord) == 24, "Invalid trace event size");
+  static_assert(sizeof(TraceEvdevKeyRecord) == 8, "Invalid trace evdev key size");
+  static_assert(sizeof(TraceEvdevAbsRecord) == 24, "Invalid trace evdev axis size");
+  static_assert(sizeof(TraceEvdevEventRecord) == 24, "Invalid trace evdev event size");
+  static_assert(sizeof(TraceJsEventRecord) == 24, "Invalid trace js event size");
+
+  /*!
+   * \brief Get the padded size of a record
+   */
+  inline size_t TraceRecordSize(size_t size)
+  {
+    return (size + INPUT_TRACE_ALIGNMENT - 1) & ~static_cast<size_t>(INPUT_TRACE_ALIGNMENT - 1);
+  }
+
+  /*!
+   * \brief An event record of any type, with its timestamp
+   */
+  struct TraceEvent
+  {
+    int64_t                  timestampUs;
+    const TraceRecordHeader* record;
+  };
+
+  /*!
+   * \brief A joystick recorded in a trace, with its events in trace order
+   */
+  struct TraceDevice
+  {
+    const TraceDeviceRecord*                 record;
+    std::string                              name;
+    std::string                              provider;
+    std::vector<const TraceEvdevKeyRecord*>  evdevKeys; // In button index order
+    std::vector<const TraceEvdevAbsRecord*>  evdevAxes; // In axis index order
+    std::vector<TraceEvent>                  events;
+  };
+
+  /*!
+   * \brief Read-only view of a trace file
+   *
+   * The file is mapped into memory and validated once when opened. Events
+   * are read in place and are valid until the trace is destroyed.
+   */
+  class CInputTrace
+  {
+  public:
+    CInputTrace(void) = default;
+    ~CInputTrace(void) { Close(); }
+
+    bool Open(const std::string& path);
+    void Close(void);
+
+    const std::string& Path(void) const { return m_path; }
+    const std::vector<TraceDevice>& Devices(void) const { return m_devices; }
+
+    /*!
+     * \brief Get the timestamps of the first and last events in the trace
+     */
+    int64_t StartTimeUs(void) const { return m_startTimeUs; }
+    int64_t EndTimeUs(void) const { return m_endTimeUs; }
+
+  private:
+    bool Index(void);
+
+    std::string              m_path;
+    const uint8_t*           m_data = nullptr;
+    size_t                   m_size = 0;
+    std::vector<TraceDevice> m_devices;
+    int64_t                  m_startTimeUs = 0;
+    int64_t                  m_endTimeUs = 0;
+  };
+
+  typedef std::shared_ptr<CInputTrace> InputTracePtr;
+}
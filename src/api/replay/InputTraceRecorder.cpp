@@ -0,0 +1,309 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "InputTraceRecorder.h"
+#include "api/Joystick.h"
+#include "log/Log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace JOYSTICK;
+
+// Capacity of each device's buffer. At 24 bytes per event this holds about a
+// second of input from a device reporting every millisecond.
+#define TRACE_BUFFER_SIZE  (64 * 1024)
+
+// Buffers are drained at this interval, or sooner when one is half full
+#define TRACE_FLUSH_INTERVAL  std::chrono::milliseconds(250)
+
+// Longest name or provider stored in a device record
+#define TRACE_MAX_STRING_LENGTH  1024
+
+// Device indices are stored in 8 bits
+#define TRACE_MAX_DEVICES  (UINT8_MAX + 1)
+
+CInputTraceBuffer::CInputTraceBuffer(unsigned int device, size_t capacity) :
+  m_device(device),
+  m_data(capacity),
+  m_mask(capacity - 1)
+{
+}
+
+bool CInputTraceBuffer::Append(const void* record, size_t size)
+{
+  const size_t head = m_head.load(std::memory_order_relaxed);
+  const size_t used = head - m_tail.load(std::memory_order_acquire);
+
+  if (used + size > m_data.size())
+  {
+    m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  // The record may wrap around the end of the ring
+  const size_t offset = head & m_mask;
+  const size_t firstSize = std::min(size, m_data.size() - offset);
+
+  const uint8_t* bytes = static_cast<const uint8_t*>(record);
+  memcpy(m_data.data() + offset, bytes, firstSize);
+  memcpy(m_data.data(), bytes + firstSize, size - firstSize);
+
+  m_head.store(head + size, std::memory_order_release);
+
+  const size_t halfCapacity = m_data.size() / 2;
+  return used < halfCapacity && used + size >= halfCapacity;
+}
+
+void CInputTraceBuffer::Drain(std::vector<uint8_t>& buffer)
+{
+  const size_t tail = m_tail.load(std::memory_order_relaxed);
+  const size_t head = m_head.load(std::memory_order_acquire);
+
+  const size_t size = head - tail;
+  const size_t offset = tail & m_mask;
+  const size_t firstSize = std::min(size, m_data.size() - offset);
+
+  buffer.insert(buffer.end(), m_data.begin() + offset, m_data.begin() + offset + firstSize);
+  buffer.insert(buffer.end(), m_data.begin(), m_data.begin() + (size - firstSize));
+
+  m_tail.store(head, std::memory_order_release);
+}
+
+CInputTraceRecorder& CInputTraceRecorder::Get(void)
+{
+  static CInputTraceRecorder _instance;
+  return _instance;
+}
+
+bool CInputTraceRecorder::Start(const std::string& path)
+{
+  Stop();
+
+  std::lock_guard<std::mutex> startLock(m_startMutex);
+
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0)
+  {
+    esyslog("Failed to create input trace %s - %s", path.c_str(), strerror(errno));
+    return false;
+  }
+
+  const TraceFileHeader header = { INPUT_TRACE_MAGIC, INPUT_TRACE_VERSION, 0 };
+  if (write(fd, &header, sizeof(header)) != sizeof(header))
+  {
+    esyslog("Failed to write input trace %s - %s", path.c_str(), strerror(errno));
+    close(fd);
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_fd = fd;
+    m_path = path;
+    m_buffers.clear();
+    m_bStop = false;
+
+    // Sessions start at 1, 0 means not recording
+    if (++m_lastSession == 0)
+      ++m_lastSession;
+    m_session.store(m_lastSession, std::memory_order_relaxed);
+  }
+
+  m_thread = std::thread(&CInputTraceRecorder::Process, this);
+
+  isyslog("Recording input to %s", path.c_str());
+
+  return true;
+}
+
+void CInputTraceRecorder::Stop(void)
+{
+  std::lock_guard<std::mutex> startLock(m_startMutex);
+
+  if (m_fd < 0)
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_session.store(0, std::memory_order_relaxed);
+    m_bStop = true;
+  }
+  m_condition.notify_one();
+
+  // The thread flushes the remaining records before exiting
+  m_thread.join();
+
+  close(m_fd);
+  m_fd = -1;
+
+  unsigned int droppedCount = 0;
+  for (const auto& buffer : m_buffers)
+    droppedCount += buffer->DroppedCount();
+
+  isyslog("Stopped recording input to %s (%u devices, %u records dropped)",
+      m_path.c_str(), static_cast<unsigned int>(m_buffers.size()), droppedCount);
+
+  // Joysticks release their buffers when the next session starts
+  m_buffers.clear();
+}
+
+InputTraceBufferPtr CInputTraceRecorder::AddDevice(unsigned int session, const CJoystick& joystick, const std::vector<uint8_t>& layout)
+{
+  const std::string name = joystick.Name().substr(0, TRACE_MAX_STRING_LENGTH);
+  const std::string provider = joystick.Provider().substr(0, TRACE_MAX_STRING_LENGTH);
+
+  const size_t deviceSize = TraceRecordSize(sizeof(TraceDeviceRecord) + name.size() + provider.size());
+
+  std::vector<uint8_t> records(deviceSize);
+  records.insert(records.end(), layout.begin(), layout.end());
+
+  // The device and its layout must fit in the buffer before any events
+  if (records.size() > TRACE_BUFFER_SIZE / 2)
+  {
+    esyslog("Can't record input from \"%s\", its layout is too large", name.c_str());
+    return InputTraceBufferPtr();
+  }
+
+  TraceDeviceRecord record = { };
+  record.header.size    = static_cast<uint16_t>(deviceSize);
+  record.header.type    = static_cast<uint8_t>(ETraceRecord::DEVICE);
+  record.buttonCount    = static_cast<uint16_t>(joystick.ButtonCount());
+  record.hatCount       = static_cast<uint16_t>(joystick.HatCount());
+  record.axisCount      = static_cast<uint16_t>(joystick.AxisCount());
+  record.motorCount     = static_cast<uint16_t>(joystick.MotorCount());
+  record.vendorId       = joystick.VendorID();
+  record.productId      = joystick.ProductID();
+  record.nameLength     = static_cast<uint16_t>(name.size());
+  record.providerLength = static_cast<uint16_t>(provider.size());
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (session != m_session.load(std::memory_order_relaxed) || m_buffers.size() >= TRACE_MAX_DEVICES)
+    return InputTraceBufferPtr();
+
+  const unsigned int device = static_cast<unsigned int>(m_buffers.size());
+
+  record.header.device = static_cast<uint8_t>(device);
+
+  memcpy(records.data(), &record, sizeof(record));
+  memcpy(records.data() + sizeof(record), name.c_str(), name.size());
+  memcpy(records.data() + sizeof(record) + name.size(), provider.c_str(), provider.size());
+
+  // Assign the layout records to the device
+  for (size_t offset = deviceSize; offset < records.size(); )
+  {
+    TraceRecordHeader* header = reinterpret_cast<TraceRecordHeader*>(records.data() + offset);
+    header->device = static_cast<uint8_t>(device);
+    offset += header->size;
+  }
+
+  // The device record is the first record of the buffer. Buffers are drained
+  // in device index order, so device records are written in index order too.
+  InputTraceBufferPtr buffer = std::make_shared<CInputTraceBuffer>(device, TRACE_BUFFER_SIZE);
+  buffer->Append(records.data(), records.size());
+
+  m_buffers.push_back(buffer);
+
+  dsyslog("Recording input from \"%s\" as device %u", name.c_str(), device);
+
+  return buffer;
+}
+
+void CInputTraceRecorder::RequestFlush(void)
+{
+  m_bFlushRequested.store(true, std::memory_order_relaxed);
+  m_condition.notify_one();
+}
+
+void CInputTraceRecorder::Process(void)
+{
+  std::vector<uint8_t> buffer;
+  buffer.reserve(TRACE_BUFFER_SIZE);
+
+  std::vector<InputTraceBufferPtr> buffers;
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  while (true)
+  {
+    m_condition.wait_for(lock, TRACE_FLUSH_INTERVAL, [this]()
+      {
+        return m_bStop || m_bFlushRequested.load(std::memory_order_relaxed);
+      });
+
+    m_bFlushRequested.store(false, std::memory_order_relaxed);
+
+    const bool bStop = m_bStop;
+
+    buffers = m_buffers;
+
+    lock.unlock();
+
+    for (const auto& deviceBuffer : buffers)
+      deviceBuffer->Drain(buffer);
+
+    Flush(buffer);
+    buffer.clear();
+
+    lock.lock();
+
+    if (bStop)
+      break;
+  }
+}
+
+void CInputTraceRecorder::Flush(const std::vector<uint8_t>& buffer)
+{
+  size_t offset = 0;
+  while (offset < buffer.size())
+  {
+    const ssize_t len = write(m_fd, buffer.data() + offset, buffer.size() - offset);
+    if (len < 0)
+    {
+      if (errno == EINTR)
+        continue;
+
+      esyslog("Failed to write input trace %s - %s", m_path.c_str(), strerror(errno));
+      break;
+    }
+
+    offset += static_cast<size_t>(len);
+  }
+}
+
+void CInputTraceSource::AddEvdevKey(unsigned int code)
+{
+  TraceEvdevKeyRecord record = { };
+  record.header.size = sizeof(record);
+  record.header.type = static_cast<uint8_t>(ETraceRecord::EVDEV_KEY);
+  record.code        = static_cast<uint16_t>(code);
+
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&record);
+  m_layout.insert(m_layout.end(), bytes, bytes + sizeof(record));
+}
+
+void CInputTraceSource::AddEvdevAbs(unsigned int code, int32_t minimum, int32_t maximum, int32_t fuzz, int32_t flat)
+{
+  TraceEvdevAbsRecord record = { };
+  record.header.size = sizeof(record);
+  record.header.type = static_cast<uint8_t>(ETraceRecord::EVDEV_ABS);
+  record.code        = static_cast<uint16_t>(code);
+  record.minimum     = minimum;
+  record.maximum     = maximum;
+  record.fuzz        = fuzz;
+  record.flat        = flat;
+
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&record);
+  m_layout.insert(m_layout.end(), bytes, bytes + sizeof(record));
+}
@@ -0,0 +1,243 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "InputTrace.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace JOYSTICK
+{
+  class CJoystick;
+
+  /*!
+   * \brief Buffer of the records of one device in the current recording
+   *
+   * A single-producer, single-consumer ring: the thread reading the device's
+   * input appends records and the recorder's flush thread drains them. The
+   * memory is allocated up front and the positions are atomic, so appending
+   * a record is a bounds check and a memcpy. If the ring fills up before
+   * it's drained, records are dropped and counted rather than blocking the
+   * input path.
+   */
+  class CInputTraceBuffer
+  {
+  public:
+    /*!
+     * \param capacity The size of the ring, a power of two
+     */
+    CInputTraceBuffer(unsigned int device, size_t capacity);
+
+    unsigned int Device(void) const { return m_device; }
+    unsigned int DroppedCount(void) const { return m_droppedCount.load(std::memory_order_relaxed); }
+
+    /*!
+     * \brief Append a record, or drop it if the ring is full
+     *
+     * Called by the producer.
+     *
+     * \return True if the ring just became half full, in which case it should
+     *         be drained before the next flush interval
+     */
+    bool Append(const void* record, size_t size);
+
+    /*!
+     * \brief Move the appended records to the end of a buffer
+     *
+     * Called by the consumer.
+     */
+    void Drain(std::vector<uint8_t>& buffer);
+
+  private:
+    const unsigned int        m_device;
+    std::vector<uint8_t>      m_data;
+    const size_t              m_mask;
+    std::atomic<size_t>       m_head{0}; // Written by the producer
+    std::atomic<size_t>       m_tail{0}; // Written by the consumer
+    std::atomic<unsigned int> m_droppedCount{0};
+  };
+
+  typedef std::shared_ptr<CInputTraceBuffer> InputTraceBufferPtr;
+
+  /*!
+   * \brief Records raw driver input to a trace file that CInputTrace can read
+   *
+   * Every recorded device gets its own CInputTraceBuffer. A background thread
+   * drains the buffers and writes them to the file, so the input path never
+   * waits on a lock or on disk I/O.
+   */
+  class CInputTraceRecorder
+  {
+  private:
+    CInputTraceRecorder(void) = default;
+
+  public:
+    static CInputTraceRecorder& Get(void);
+
+    ~CInputTraceRecorder(void) { Stop(); }
+
+    /*!
+     * \brief Start recording to a new file, replacing any existing file
+     */
+    bool Start(const std::string& path);
+
+    /*!
+     * \brief Flush the buffered records and close the file
+     */
+    void Stop(void);
+
+    /*!
+     * \brief Get the current recording session, or 0 if not recording
+     */
+    unsigned int Session(void) const { return m_session.load(std::memory_order_relaxed); }
+
+    /*!
+     * \brief Add a device to the trace
+     *
+     * \param layout Records that describe how the device's events are decoded,
+     *               written after the device record
+     *
+     * \return The buffer for the device's records, or empty if the device
+     *         can't be recorded in this session
+     */
+    InputTraceBufferPtr AddDevice(unsigned int session, const CJoystick& joystick, const std::vector<uint8_t>& layout);
+
+    /*!
+     * \brief Wake the flush thread before its next interval
+     */
+    void RequestFlush(void);
+
+  private:
+    void Process(void);
+    void Flush(const std::vector<uint8_t>& buffer);
+
+    std::atomic<unsigned int> m_session{0};
+    unsigned int              m_lastSession = 0;
+    int                       m_fd = -1;
+    std::string               m_path;
+
+    // Buffers of the devices in the recording, in device index order,
+    // guarded by m_mutex
+    std::vector<InputTraceBufferPtr> m_buffers;
+    std::mutex                       m_mutex;
+
+    // Flush thread
+    std::thread               m_thread;
+    std::condition_variable   m_condition;
+    bool                      m_bStop = false;
+    std::atomic<bool>         m_bFlushRequested{false};
+    std::mutex                m_startMutex; // Serializes Start() and Stop()
+  };
+
+  /*!
+   * \brief A joystick's device in the current recording
+   *
+   * Owned by the joystick and only used by the thread reading its input.
+   * The device is added to the trace by the first event recorded in each
+   * session. When not recording, recording an event is a single relaxed
+   * atomic load.
+   */
+  class CInputTraceSource
+  {
+  public:
+    /*!
+     * \brief Add an evdev button to the device's layout, in button index order
+     */
+    void AddEvdevKey(unsigned int code);
+
+    /*!
+     * \brief Add an evdev axis to the device's layout, in axis index order
+     */
+    void AddEvdevAbs(unsigned int code, int32_t minimum, int32_t maximum, int32_t fuzz, int32_t flat);
+
+    /*!
+     * \brief Clear the device's layout, before the device is opened again
+     */
+    void ClearLayout(void) { m_layout.clear(); }
+
+    /*!
+     * \brief Record an input_event read from an evdev device
+     */
+    void RecordEvdevEvent(const CJoystick& joystick, uint16_t type, uint16_t code, int32_t value, int64_t timestampUs)
+    {
+      CInputTraceBuffer* buffer = GetBuffer(joystick);
+      if (buffer == nullptr)
+        return;
+
+      TraceEvdevEventRecord record = { };
+      record.header.size   = sizeof(record);
+      record.header.type   = static_cast<uint8_t>(ETraceRecord::EVDEV_EVENT);
+      record.header.device = static_cast<uint8_t>(buffer->Device());
+      record.type          = type;
+      record.code          = code;
+      record.timestampUs   = timestampUs;
+      record.value         = value;
+
+      Append(*buffer, &record, sizeof(record));
+    }
+
+    /*!
+     * \brief Record a js_event read from a Linux Joystick API device
+     */
+    void RecordJsEvent(const CJoystick& joystick, uint8_t type, uint8_t number, int16_t value, uint32_t time, int64_t timestampUs)
+    {
+      CInputTraceBuffer* buffer = GetBuffer(joystick);
+      if (buffer == nullptr)
+        return;
+
+      TraceJsEventRecord record = { };
+      record.header.size   = sizeof(record);
+      record.header.type   = static_cast<uint8_t>(ETraceRecord::JS_EVENT);
+      record.header.device = static_cast<uint8_t>(buffer->Device());
+      record.type          = type;
+      record.number        = number;
+      record.value         = value;
+      record.timestampUs   = timestampUs;
+      record.time          = time;
+
+      Append(*buffer, &record, sizeof(record));
+    }
+
+  private:
+    CInputTraceBuffer* GetBuffer(const CJoystick& joystick)
+    {
+      CInputTraceRecorder& recorder = CInputTraceRecorder::Get();
+
+      const unsigned int session = recorder.Session();
+      if (session == 0)
+        return nullptr;
+
+      if (session != m_session)
+      {
+        m_session = session;
+        m_buffer = recorder.AddDevice(session, joystick, m_layout);
+      }
+
+      return m_buffer.get();
+    }
+
+    static void Append(CInputTraceBuffer& buffer, const void* record, size_t size)
+    {
+      if (buffer.Append(record, size))
+        CInputTraceRecorder::Get().RequestFlush();
+    }
+
+    unsigned int         m_session = 0;
+    InputTraceBufferPtr  m_buffer;
+    std::vector<uint8_t> m_layout; // Layout records of the device, in trace format
+  };
+}
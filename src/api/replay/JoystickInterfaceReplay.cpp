@@ -0,0 +1,79 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "JoystickInterfaceReplay.h"
+#include "api/JoystickTypes.h"
+#include "log/Log.h"
+
+#include <stdlib.h>
+
+using namespace JOYSTICK;
+
+#define REPLAY_TRACE_VARIABLE  "JOYSTICK_REPLAY_TRACE"
+#define REPLAY_SPEED_VARIABLE  "JOYSTICK_REPLAY_SPEED"
+#define REPLAY_LOOP_VARIABLE   "JOYSTICK_REPLAY_LOOP"
+
+namespace
+{
+  std::string GetEnvironment(const char* name)
+  {
+    const char* value = getenv(name);
+    return value != nullptr ? value : "";
+  }
+}
+
+CJoystickInterfaceReplay::CJoystickInterfaceReplay(void) :
+  m_tracePath(GetEnvironment(REPLAY_TRACE_VARIABLE)),
+  m_speed(GetEnvironment(REPLAY_SPEED_VARIABLE) == "fast" ? EReplaySpeed::FAST : EReplaySpeed::REAL_TIME),
+  m_bLoop(GetEnvironment(REPLAY_LOOP_VARIABLE) == "1")
+{
+}
+
+CJoystickInterfaceReplay::CJoystickInterfaceReplay(const std::string& tracePath, EReplaySpeed speed, bool bLoop) :
+  m_tracePath(tracePath),
+  m_speed(speed),
+  m_bLoop(bLoop)
+{
+}
+
+EJoystickInterface CJoystickInterfaceReplay::Type(void) const
+{
+  return EJoystickInterface::REPLAY;
+}
+
+bool CJoystickInterfaceReplay::Initialize(void)
+{
+  if (m_tracePath.empty())
+  {
+    dsyslog("No input trace to replay, set %s to enable replay", REPLAY_TRACE_VARIABLE);
+    return true;
+  }
+
+  InputTracePtr trace = std::make_shared<CInputTrace>();
+  if (!trace->Open(m_tracePath))
+    return false;
+
+  m_trace = std::move(trace);
+
+  for (unsigned int i = 0; i < m_trace->Devices().size(); i++)
+    m_joysticks.emplace_back(std::make_shared<CJoystickReplay>(m_trace, i, m_speed, m_bLoop));
+
+  return true;
+}
+
+void CJoystickInterfaceReplay::Deinitialize(void)
+{
+  m_joysticks.clear();
+  m_trace.reset();
+}
+
+bool CJoystickInterfaceReplay::ScanForJoysticks(JoystickVector& joysticks)
+{
+  joysticks.insert(joysticks.end(), m_joysticks.begin(), m_joysticks.end());
+  return true;
+}
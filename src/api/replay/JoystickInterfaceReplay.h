@@ -0,0 +1,52 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "InputTrace.h"
+#include "JoystickReplay.h"
+#include "api/IJoystickInterface.h"
+
+#include <string>
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Interface presenting the devices of a recorded input trace
+   *
+   * Used to exercise the joystick pipeline without input hardware. When
+   * created by CJoystickManager, the trace is configured by environment
+   * variables:
+   *
+   *   JOYSTICK_REPLAY_TRACE  Path of the trace to play
+   *   JOYSTICK_REPLAY_SPEED  "realtime" (default) or "fast"
+   *   JOYSTICK_REPLAY_LOOP   "1" to restart the trace when it ends
+   *
+   * Without a trace, the interface has no joysticks.
+   */
+  class CJoystickInterfaceReplay : public IJoystickInterface
+  {
+  public:
+    CJoystickInterfaceReplay(void);
+    CJoystickInterfaceReplay(const std::string& tracePath, EReplaySpeed speed, bool bLoop);
+    virtual ~CJoystickInterfaceReplay(void) { Deinitialize(); }
+
+    // implementation of IJoystickInterface
+    virtual EJoystickInterface Type(void) const override;
+    virtual bool Initialize(void) override;
+    virtual void Deinitialize(void) override;
+    virtual bool ScanForJoysticks(JoystickVector& joysticks) override;
+
+  private:
+    std::string    m_tracePath;
+    EReplaySpeed   m_speed;
+    bool           m_bLoop;
+    InputTracePtr  m_trace;
+    JoystickVector m_joysticks;
+  };
+}
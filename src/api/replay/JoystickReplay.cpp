@@ -0,0 +1,242 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "JoystickReplay.h"
+#include "api/JoystickTypes.h"
+#include "utils/LatencyHistogram.h"
+
+#if defined(HAVE_REPLAY_RAW_EVENTS)
+  #include <linux/input.h>
+  #include <linux/joystick.h>
+
+  // js_event axis values range from -32767 to 32767
+  #define JS_MAX_AXIS  32767
+#endif
+
+using namespace JOYSTICK;
+
+CJoystickReplay::CJoystickReplay(const InputTracePtr& trace, unsigned int deviceIndex, EReplaySpeed speed, bool bLoop)
+ : CJoystick(EJoystickInterface::REPLAY),
+   m_trace(trace),
+   m_device(trace->Devices()[deviceIndex]),
+   m_deviceIndex(deviceIndex),
+   m_speed(speed),
+   m_bLoop(bLoop),
+   m_cursor(0),
+   m_baseTimeUs(-1)
+#if defined(HAVE_REPLAY_RAW_EVENTS)
+   , m_bDropped(false)
+#endif
+{
+  const TraceDeviceRecord& record = *m_device.record;
+
+  // Present the device as it was recorded so that its button maps apply
+  if (!m_device.provider.empty())
+    SetProvider(m_device.provider);
+
+  SetName(m_device.name);
+  SetVendorID(record.vendorId);
+  SetProductID(record.productId);
+  SetButtonCount(record.buttonCount);
+  SetHatCount(record.hatCount);
+  SetAxisCount(record.axisCount);
+
+#if defined(HAVE_REPLAY_RAW_EVENTS)
+  // Button and axis indices are assigned in layout order, like the driver
+  for (const TraceEvdevKeyRecord* key : m_device.evdevKeys)
+    m_decodeTable.AddButton(key->code);
+
+  for (const TraceEvdevAbsRecord* abs : m_device.evdevAxes)
+  {
+    input_absinfo info = { };
+    info.minimum = abs->minimum;
+    info.maximum = abs->maximum;
+    info.fuzz = abs->fuzz;
+    info.flat = abs->flat;
+    m_decodeTable.AddAxis(abs->code, info);
+  }
+#endif
+}
+
+bool CJoystickReplay::Equals(const CJoystick* rhs) const
+{
+  if (rhs == nullptr)
+    return false;
+
+  const CJoystickReplay* rhsReplay = dynamic_cast<const CJoystickReplay*>(rhs);
+  if (rhsReplay == nullptr)
+    return false;
+
+  return m_trace->Path() == rhsReplay->m_trace->Path() &&
+         m_deviceIndex == rhsReplay->m_deviceIndex;
+}
+
+std::string CJoystickReplay::Identity(void) const
+{
+  return m_trace->Path() + "|" + std::to_string(m_deviceIndex);
+}
+
+bool CJoystickReplay::ScanEvents(void)
+{
+  if (m_device.events.empty())
+    return true;
+
+  if (m_speed == EReplaySpeed::REAL_TIME)
+    ScanRealTime();
+  else
+    ScanFrame();
+
+  return true;
+}
+
+void CJoystickReplay::ScanRealTime(void)
+{
+  const std::vector<TraceEvent>& events = m_device.events;
+
+  const int64_t nowUs = GetMonotonicTimeUs();
+  const int64_t durationUs = m_trace->EndTimeUs() - m_trace->StartTimeUs() + 1;
+
+  if (m_baseTimeUs < 0)
+    m_baseTimeUs = nowUs;
+
+  while (true)
+  {
+    if (m_cursor >= events.size())
+    {
+      if (!m_bLoop)
+        break;
+
+      m_cursor = 0;
+      m_baseTimeUs += durationUs;
+
+      // Don't replay every missed loop after a long stall
+      if (m_baseTimeUs + durationUs < nowUs)
+        m_baseTimeUs = nowUs;
+    }
+
+    const TraceEvent& event = events[m_cursor];
+
+    const int64_t eventTimeUs = m_baseTimeUs + (event.timestampUs - m_trace->StartTimeUs());
+    if (eventTimeUs > nowUs)
+      break;
+
+    ApplyEvent(*event.record);
+    SetInputTime(eventTimeUs);
+
+    m_cursor++;
+  }
+}
+
+void CJoystickReplay::ScanFrame(void)
+{
+  const std::vector<TraceEvent>& events = m_device.events;
+
+  if (m_cursor >= events.size())
+  {
+    if (!m_bLoop)
+      return;
+
+    m_cursor = 0;
+  }
+
+  const int64_t frameTimeUs = events[m_cursor].timestampUs;
+
+  while (m_cursor < events.size() && events[m_cursor].timestampUs == frameTimeUs)
+    ApplyEvent(*events[m_cursor++].record);
+}
+
+void CJoystickReplay::ApplyEvent(const TraceRecordHeader& record)
+{
+  switch (static_cast<ETraceRecord>(record.type))
+  {
+  case ETraceRecord::BUTTON:
+  {
+    const TraceEventRecord& event = reinterpret_cast<const TraceEventRecord&>(record);
+    SetButtonValue(event.index, event.value != 0.0f ? JOYSTICK_STATE_BUTTON_PRESSED : JOYSTICK_STATE_BUTTON_UNPRESSED);
+    break;
+  }
+  case ETraceRecord::HAT:
+  {
+    const TraceEventRecord& event = reinterpret_cast<const TraceEventRecord&>(record);
+    SetHatValue(event.index, static_cast<JOYSTICK_STATE_HAT>(static_cast<int>(event.value)));
+    break;
+  }
+  case ETraceRecord::AXIS:
+  {
+    const TraceEventRecord& event = reinterpret_cast<const TraceEventRecord&>(record);
+    SetAxisValue(event.index, event.value);
+    break;
+  }
+#if defined(HAVE_REPLAY_RAW_EVENTS)
+  case ETraceRecord::EVDEV_EVENT:
+    ApplyEvdevEvent(reinterpret_cast<const TraceEvdevEventRecord&>(record));
+    break;
+  case ETraceRecord::JS_EVENT:
+    ApplyJsEvent(reinterpret_cast<const TraceJsEventRecord&>(record));
+    break;
+#endif
+  default:
+    break;
+  }
+}
+
+#if defined(HAVE_REPLAY_RAW_EVENTS)
+
+void CJoystickReplay::ApplyEvdevEvent(const TraceEvdevEventRecord& event)
+{
+  // The driver recorded the state it queried after SYN_DROPPED as events
+  // following the next SYN_REPORT
+  if (m_bDropped && event.type != EV_SYN)
+    return;
+
+  switch (event.type)
+  {
+  case EV_SYN:
+  {
+    if (event.code == SYN_DROPPED)
+      m_bDropped = true;
+    else if (event.code == SYN_REPORT)
+      m_bDropped = false;
+    break;
+  }
+  case EV_KEY:
+  {
+    const int buttonIndex = m_decodeTable.GetButton(event.code);
+    if (buttonIndex >= 0)
+      SetButtonValue(buttonIndex, event.value ? JOYSTICK_STATE_BUTTON_PRESSED : JOYSTICK_STATE_BUTTON_UNPRESSED);
+    break;
+  }
+  case EV_ABS:
+  {
+    const UdevAxisBinding* axis = m_decodeTable.GetAxis(event.code);
+    if (axis != nullptr)
+      SetAxisValue(axis->axisIndex, axis->Normalize(event.value));
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+void CJoystickReplay::ApplyJsEvent(const TraceJsEventRecord& event)
+{
+  // Initial events are ignored, like the driver does
+  switch (event.type)
+  {
+  case JS_EVENT_BUTTON:
+    SetButtonValue(event.number, event.value ? JOYSTICK_STATE_BUTTON_PRESSED : JOYSTICK_STATE_BUTTON_UNPRESSED);
+    break;
+  case JS_EVENT_AXIS:
+    SetAxisValue(event.number, static_cast<float>(event.value) / JS_MAX_AXIS);
+    break;
+  default:
+    break;
+  }
+}
+
+#endif
@@ -0,0 +1,79 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "InputTrace.h"
+#include "api/Joystick.h"
+
+#if defined(HAVE_REPLAY_RAW_EVENTS)
+  #include "api/udev/UdevDecodeTable.h"
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+namespace JOYSTICK
+{
+  enum class EReplaySpeed
+  {
+    REAL_TIME,    // Events are applied when their recorded time comes up
+    FAST,         // Every scan applies the next frame of events
+  };
+
+  /*!
+   * \brief Joystick that plays back the events of a device in a trace
+   *
+   * In real time, the trace starts playing on the first scan. As fast as
+   * possible, events with the same timestamp form a frame, and each call to
+   * ScanEvents() applies one frame.
+   *
+   * Raw driver events are decoded like their driver does, on platforms with
+   * the driver's headers. Elsewhere only decoded events are played.
+   */
+  class CJoystickReplay : public CJoystick
+  {
+  public:
+    CJoystickReplay(const InputTracePtr& trace, unsigned int deviceIndex, EReplaySpeed speed, bool bLoop);
+    virtual ~CJoystickReplay(void) { Deinitialize(); }
+
+    // implementation of CJoystick
+    virtual bool Equals(const CJoystick* rhs) const override;
+    virtual std::string Identity(void) const override;
+
+    /*!
+     * \brief True once every event has been applied. Never true when looping.
+     */
+    bool IsFinished(void) const { return !m_bLoop && m_cursor >= m_device.events.size(); }
+
+  protected:
+    virtual bool ScanEvents(void) override;
+
+  private:
+    void ScanRealTime(void);
+    void ScanFrame(void);
+    void ApplyEvent(const TraceRecordHeader& record);
+#if defined(HAVE_REPLAY_RAW_EVENTS)
+    void ApplyEvdevEvent(const TraceEvdevEventRecord& event);
+    void ApplyJsEvent(const TraceJsEventRecord& event);
+#endif
+
+    const InputTracePtr m_trace;
+    const TraceDevice&  m_device;
+    const unsigned int  m_deviceIndex;
+    const EReplaySpeed  m_speed;
+    const bool          m_bLoop;
+    size_t              m_cursor;
+    int64_t             m_baseTimeUs; // Monotonic time of the start of the trace, or -1 until the first scan
+#if defined(HAVE_REPLAY_RAW_EVENTS)
+    CUdevDecodeTable    m_decodeTable; // Built from the device's evdev layout
+    bool                m_bDropped;    // Discarding evdev events until the next SYN_REPORT
+#endif
+  };
+}
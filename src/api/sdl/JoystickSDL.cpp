@@ -25,6 +25,8 @@ CJoystickSDL::CJoystickSDL(unsigned int index) :
   SetName("SDL Game Controller");
   SetButtonCount(SDL_CONTROLLER_BUTTON_MAX);
   SetAxisCount(SDL_CONTROLLER_AXIS_MAX);
+  SetAnalogStick(SDL_CONTROLLER_AXIS_LEFTX, SDL_CONTROLLER_AXIS_LEFTY);
+  SetAnalogStick(SDL_CONTROLLER_AXIS_RIGHTX, SDL_CONTROLLER_AXIS_RIGHTY);
 }
 
 bool CJoystickSDL::Equals(const CJoystick* rhs) const
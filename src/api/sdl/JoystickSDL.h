@@ -23,6 +23,7 @@ namespace JOYSTICK
 
     // implementation of CJoystick
     virtual bool Equals(const CJoystick* rhs) const override;
+    virtual std::string Identity(void) const override { return std::to_string(m_index); }
     virtual bool Initialize(void) override;
     virtual void Deinitialize(void) override;
 
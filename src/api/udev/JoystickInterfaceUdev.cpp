@@ -8,9 +8,14 @@
 
 #include "JoystickInterfaceUdev.h"
 #include "JoystickUdev.h"
+#include "api/JoystickManager.h"
 #include "api/JoystickTypes.h"
+#include "log/Log.h"
 
+#include <algorithm>
 #include <libudev.h>
+#include <poll.h>
+#include <string.h>
 #include <utility>
 
 using namespace JOYSTICK;
@@ -26,9 +31,19 @@ ButtonMap CJoystickInterfaceUdev::m_buttonMap = {
     }),
 };
 
+namespace
+{
+  bool IsJoystick(udev_device* dev)
+  {
+    const char* value = udev_device_get_property_value(dev, "ID_INPUT_JOYSTICK");
+    return value != nullptr && strcmp(value, "1") == 0;
+  }
+}
+
 CJoystickInterfaceUdev::CJoystickInterfaceUdev() :
   m_udev(nullptr),
-  m_udev_mon(nullptr)
+  m_udev_mon(nullptr),
+  m_bEnumerated(false)
 {
 }
 
@@ -50,11 +65,20 @@ bool CJoystickInterfaceUdev::Initialize()
      udev_monitor_enable_receiving(m_udev_mon);
   }
 
+  // Joysticks keep their own reference, so the worker outlives the interface
+  // until every joystick is gone
+  m_rumbleWorker = std::make_shared<CUdevRumbleWorker>();
+
   return true;
 }
 
 void CJoystickInterfaceUdev::Deinitialize()
 {
+  m_joysticks.clear();
+  m_bEnumerated = false;
+
+  m_rumbleWorker.reset();
+
   if (m_udev_mon)
   {
     udev_monitor_unref(m_udev_mon);
@@ -69,6 +93,80 @@ void CJoystickInterfaceUdev::Deinitialize()
 }
 
 bool CJoystickInterfaceUdev::ScanForJoysticks(JoystickVector& joysticks)
+{
+  // Without a monitor there's no way to keep the list up to date
+  if (!m_udev_mon)
+    return EnumerateJoysticks(joysticks);
+
+  if (!m_bEnumerated)
+  {
+    JoystickVector enumerated;
+    if (!EnumerateJoysticks(enumerated))
+      return false;
+
+    m_joysticks = std::move(enumerated);
+    m_bEnumerated = true;
+  }
+
+  joysticks.insert(joysticks.end(), m_joysticks.begin(), m_joysticks.end());
+
+  return true;
+}
+
+void CJoystickInterfaceUdev::ProcessHotplug(void)
+{
+  if (!m_udev_mon || !m_bEnumerated)
+    return;
+
+  pollfd fds = { };
+  fds.fd     = udev_monitor_get_fd(m_udev_mon);
+  fds.events = POLLIN;
+
+  while (poll(&fds, 1, 0) > 0 && (fds.revents & POLLIN))
+  {
+    struct udev_device* dev = udev_monitor_receive_device(m_udev_mon);
+    if (dev == nullptr)
+      break;
+
+    const char* action  = udev_device_get_action(dev);
+    const char* devnode = udev_device_get_devnode(dev);
+
+    if (action != nullptr && devnode != nullptr)
+    {
+      if (strcmp(action, "add") == 0 && IsJoystick(dev))
+      {
+        JoystickPtr joystick = JoystickPtr(new CJoystickUdev(dev, devnode, m_rumbleWorker));
+
+        dsyslog("[udev]: Joystick connected: %s", devnode);
+
+        if (CJoystickManager::Get().AddJoystick(joystick))
+          m_joysticks.push_back(joystick);
+      }
+      else if (strcmp(action, "remove") == 0)
+      {
+        const dev_t deviceNumber = udev_device_get_devnum(dev);
+
+        auto it = std::find_if(m_joysticks.begin(), m_joysticks.end(),
+          [deviceNumber](const JoystickPtr& joystick)
+          {
+            return static_cast<CJoystickUdev*>(joystick.get())->DeviceNumber() == deviceNumber;
+          });
+
+        if (it != m_joysticks.end())
+        {
+          dsyslog("[udev]: Joystick disconnected: %s", devnode);
+
+          CJoystickManager::Get().RemoveJoystick(*it);
+          m_joysticks.erase(it);
+        }
+      }
+    }
+
+    udev_device_unref(dev);
+  }
+}
+
+bool CJoystickInterfaceUdev::EnumerateJoysticks(JoystickVector& joysticks)
 {
   if (!m_udev)
     return false;
@@ -92,7 +190,7 @@ bool CJoystickInterfaceUdev::ScanForJoysticks(JoystickVector& joysticks)
 
      if (devnode != nullptr)
      {
-       JoystickPtr joystick = JoystickPtr(new CJoystickUdev(dev, devnode));
+       JoystickPtr joystick = JoystickPtr(new CJoystickUdev(dev, devnode, m_rumbleWorker));
        joysticks.push_back(joystick);
      }
 
@@ -28,6 +28,7 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "UdevRumble.h"
 #include "api/IJoystickInterface.h"
 
 struct udev;
@@ -48,11 +49,20 @@ namespace JOYSTICK
     virtual void Deinitialize() override;
     virtual bool SupportsRumble(void) const { return true; }
     virtual bool ScanForJoysticks(JoystickVector& joysticks) override;
+    virtual void ProcessHotplug(void) override;
     virtual const ButtonMap& GetButtonMap() override;
 
   private:
-    udev*         m_udev;
-    udev_monitor* m_udev_mon;
+    /*!
+     * \brief Enumerate all joysticks known to udev
+     */
+    bool EnumerateJoysticks(JoystickVector& joysticks);
+
+    udev*               m_udev;
+    udev_monitor*       m_udev_mon;
+    UdevRumbleWorkerPtr m_rumbleWorker;
+    JoystickVector      m_joysticks;   // Connected joysticks, kept up to date by the monitor
+    bool                m_bEnumerated; // True once m_joysticks holds a full enumeration
 
     static ButtonMap m_buttonMap;
   };
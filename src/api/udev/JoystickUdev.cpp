@@ -18,7 +18,9 @@
 #include <string.h>
 #include <sys/ioctl.h>
 #include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
+#include <utility>
 
 using namespace JOYSTICK;
 
@@ -33,16 +35,29 @@ using namespace JOYSTICK;
 // From RetroArch
 #define NBITS(x)  ((((x) - 1) / (sizeof(long) * CHAR_BIT)) + 1)
 
-CJoystickUdev::CJoystickUdev(udev_device* dev, const char* path)
+namespace
+{
+  int64_t GetRealtimeTimeUs(void)
+  {
+    timespec now = { };
+    clock_gettime(CLOCK_REALTIME, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+  }
+}
+
+CJoystickUdev::CJoystickUdev(udev_device* dev, const char* path, const UdevRumbleWorkerPtr& rumbleWorker)
  : CJoystick(EJoystickInterface::UDEV),
    m_dev(dev),
    m_path(path),
    m_deviceNumber(0),
    m_fd(INVALID_FD),
    m_bInitialized(false),
-   m_effect(-1),
-   m_motors(),
-   m_previousMotors()
+   m_bDropped(false),
+   m_droppedCount(0),
+   m_bMonotonicTime(false),
+   m_realtimeOffsetUs(0),
+   m_effectCount(0),
+   m_rumbleWorker(rumbleWorker)
 {
   // Must initialize in the constructor to fill out joystick properties
   Initialize();
@@ -70,6 +85,12 @@ bool CJoystickUdev::Initialize(void)
     if (!CJoystick::Initialize())
       return false;
 
+    if (MotorCount() > 0 && m_rumbleWorker)
+    {
+      m_rumble = std::make_shared<CUdevRumble>(m_fd, Name(), m_effectCount);
+      m_rumbleWorker->Register(m_rumble);
+    }
+
     m_bInitialized = true;
   }
 
@@ -78,6 +99,13 @@ bool CJoystickUdev::Initialize(void)
 
 void CJoystickUdev::Deinitialize(void)
 {
+  if (m_rumble)
+  {
+    // The worker may still hold a reference, the rumble has its own descriptor
+    m_rumbleWorker->Unregister(m_rumble);
+    m_rumble.reset();
+  }
+
   if (m_fd >= 0)
   {
     close(m_fd);
@@ -87,90 +115,6 @@ void CJoystickUdev::Deinitialize(void)
   CJoystick::Deinitialize();
 }
 
-void CJoystickUdev::ProcessEvents(void)
-{
-
-  std::array<uint16_t, MOTOR_COUNT> motors;
-  std::array<uint16_t, MOTOR_COUNT> previousMotors;
-
-  {
-    std::lock_guard<std::recursive_mutex> lock(m_mutex);
-    motors         = m_motors;
-    previousMotors = m_previousMotors;
-  }
-
-  uint32_t oldStrength = static_cast<uint32_t>(previousMotors[MOTOR_STRONG]) +
-                         static_cast<uint32_t>(previousMotors[MOTOR_WEAK]);
-  uint32_t newStrength = static_cast<uint32_t>(motors[MOTOR_STRONG]) +
-                         static_cast<uint32_t>(motors[MOTOR_WEAK]);
-
-  bool bWasPlaying = (oldStrength > 0);
-  bool bIsPlaying = (newStrength > 0);
-
-  if (!bWasPlaying && !bIsPlaying)
-  {
-    // Nothing to do
-  }
-  else if (!bWasPlaying && bIsPlaying)
-  {
-    UpdateMotorState(motors);
-
-    // Play effect
-    Play(true);
-  }
-  else if (bWasPlaying && !bIsPlaying)
-  {
-    // Stop the effect
-    Play(false);
-  }
-  else
-  {
-    if (oldStrength != newStrength)
-      UpdateMotorState(motors);
-  }
-
-  {
-    std::lock_guard<std::recursive_mutex> lock(m_mutex);
-    m_previousMotors = motors;
-  }
-}
-
-void CJoystickUdev::Play(bool bPlayStop)
-{
-  struct input_event play = { { } };
-
-  play.type  = EV_FF;
-  play.code  = m_effect;
-  play.value = bPlayStop;
-
-  if (write(m_fd, &play, sizeof(play)) < (ssize_t)sizeof(play))
-    esyslog("[udev]: Failed to play rumble effect %d on \"%s\" - %s", m_effect, Name().c_str(), strerror(errno));
-
-  if (!bPlayStop)
-    m_effect = -1;
-}
-
-void CJoystickUdev::UpdateMotorState(const std::array<uint16_t, MOTOR_COUNT>& motors)
-{
-  struct ff_effect e = { };
-
-  e.type                      = FF_RUMBLE;
-  e.id                        = m_effect;
-  e.u.rumble.strong_magnitude = motors[MOTOR_STRONG];
-  e.u.rumble.weak_magnitude   = motors[MOTOR_WEAK];
-
-  if (ioctl(m_fd, EVIOCSFF, &e) < 0)
-  {
-    esyslog("Failed to set rumble effect %d (0x%04x, 0x%04x) on \"%s\" - %s",
-        e.id, e.u.rumble.strong_magnitude, e.u.rumble.weak_magnitude,
-        Name().c_str(), strerror(errno));
-  }
-  else
-  {
-    m_effect = e.id;
-  }
-}
-
 bool CJoystickUdev::ScanEvents(void)
 {
   input_event events[32];
@@ -182,42 +126,62 @@ bool CJoystickUdev::ScanEvents(void)
   while ((len = read(m_fd, events, sizeof(events))) > 0)
   {
     len /= sizeof(*events);
+
+    if (!m_bMonotonicTime)
+      m_realtimeOffsetUs = GetMonotonicTimeUs() - GetRealtimeTimeUs();
     for (unsigned int i = 0; i < static_cast<unsigned int>(len); i++)
     {
       const input_event& event = events[i];
 
-      int code = event.code;
+      m_traceSource.RecordEvdevEvent(*this, event.type, event.code, event.value, GetEventTime(event));
+
+      const unsigned int code = event.code;
+
+      // After SYN_DROPPED, the events up to the next SYN_REPORT are only a
+      // partial report and the state is re-queried instead
+      if (m_bDropped && event.type != EV_SYN)
+        continue;
 
       switch (event.type)
       {
-        case EV_KEY:
+        case EV_SYN:
         {
-          if (code >= BTN_MISC || (code >= KEY_UP && code <= KEY_DOWN))
+          if (code == SYN_DROPPED)
           {
-            auto it = m_button_bind.find(code);
-            if (it != m_button_bind.end())
+            m_bDropped = true;
+            m_droppedCount++;
+            dsyslog("[udev]: Events dropped by the kernel on \"%s\" (%u times)", Name().c_str(), m_droppedCount);
+          }
+          else if (code == SYN_REPORT)
+          {
+            if (m_bDropped)
             {
-              const unsigned int buttonIndex = it->second;
-              SetButtonValue(buttonIndex, event.value ? JOYSTICK_STATE_BUTTON_PRESSED : JOYSTICK_STATE_BUTTON_UNPRESSED);
+              m_bDropped = false;
+              Resync(GetEventTime(event));
             }
+
+            if (m_bMonotonicTime)
+              SetInputTime(GetEventTime(event));
+          }
+          break;
+        }
+        case EV_KEY:
+        {
+          const int buttonIndex = m_decodeTable.GetButton(code);
+          if (buttonIndex >= 0)
+          {
+            const JOYSTICK_STATE_BUTTON buttonValue = event.value ? JOYSTICK_STATE_BUTTON_PRESSED : JOYSTICK_STATE_BUTTON_UNPRESSED;
+            SetButtonValue(buttonIndex, buttonValue);
           }
           break;
         }
         case EV_ABS:
         {
-          if (code < ABS_MISC)
+          const UdevAxisBinding* axis = m_decodeTable.GetAxis(code);
+          if (axis != nullptr)
           {
-            auto it = m_axes_bind.find(code);
-            if (it != m_axes_bind.end())
-            {
-              const unsigned int axisIndex = it->second.axisIndex;
-              const input_absinfo& info = it->second.axisInfo;
-
-              if (event.value >= 0)
-                SetAxisValue(axisIndex, event.value, info.maximum);
-              else
-                SetAxisValue(axisIndex, event.value, -info.minimum);
-            }
+            const float axisValue = axis->Normalize(event.value);
+            SetAxisValue(axis->axisIndex, axisValue);
           }
           break;
         }
@@ -230,6 +194,54 @@ bool CJoystickUdev::ScanEvents(void)
   return true;
 }
 
+int64_t CJoystickUdev::GetEventTime(const input_event& event) const
+{
+  return static_cast<int64_t>(event.time.tv_sec) * 1000000 + event.time.tv_usec + m_realtimeOffsetUs;
+}
+
+void CJoystickUdev::Resync(int64_t eventTimeUs)
+{
+  unsigned long keybit[NBITS(KEY_MAX)] = { };
+
+  if (ioctl(m_fd, EVIOCGKEY(sizeof(keybit)), keybit) < 0)
+  {
+    esyslog("[udev]: Failed to query key state of \"%s\" - %s", Name().c_str(), strerror(errno));
+  }
+  else
+  {
+    for (unsigned int i = 0; i < KEY_MAX; i++)
+    {
+      const int buttonIndex = m_decodeTable.GetButton(i);
+      if (buttonIndex >= 0)
+      {
+        const JOYSTICK_STATE_BUTTON buttonValue = test_bit(i, keybit) ? JOYSTICK_STATE_BUTTON_PRESSED : JOYSTICK_STATE_BUTTON_UNPRESSED;
+        SetButtonValue(buttonIndex, buttonValue);
+
+        // Recorded as the events that would have reported the state
+        m_traceSource.RecordEvdevEvent(*this, EV_KEY, i, test_bit(i, keybit) ? 1 : 0, eventTimeUs);
+      }
+    }
+  }
+
+  for (unsigned int i = 0; i < ABS_MISC; i++)
+  {
+    const UdevAxisBinding* axis = m_decodeTable.GetAxis(i);
+    if (axis == nullptr)
+      continue;
+
+    input_absinfo abs;
+    if (ioctl(m_fd, EVIOCGABS(i), &abs) < 0)
+    {
+      esyslog("[udev]: Failed to query axis state of \"%s\" - %s", Name().c_str(), strerror(errno));
+      break;
+    }
+
+    const float axisValue = axis->Normalize(abs.value);
+    SetAxisValue(axis->axisIndex, axisValue);
+    m_traceSource.RecordEvdevEvent(*this, EV_ABS, i, abs.value, eventTimeUs);
+  }
+}
+
 bool CJoystickUdev::OpenJoystick()
 {
   unsigned long evbit[NBITS(EV_MAX)]   = { };
@@ -248,6 +260,10 @@ bool CJoystickUdev::OpenJoystick()
   if (!test_bit(EV_KEY, evbit))
     return false;
 
+  // Timestamp events with the monotonic clock so input latency can be measured
+  int clockId = CLOCK_MONOTONIC;
+  m_bMonotonicTime = (ioctl(m_fd, EVIOCSCLOCKID, &clockId) >= 0);
+
   return true;
 }
 
@@ -292,20 +308,27 @@ bool CJoystickUdev::GetProperties()
 
   // Go through all possible keycodes, check if they are used, and map them to
   // button/axes/hat indices
-  unsigned int buttons = 0;
+  m_decodeTable.Clear();
+  m_traceSource.ClearLayout();
+
   for (unsigned int i = KEY_UP; i <= KEY_DOWN; i++)
   {
     if (test_bit(i, keybit))
-      m_button_bind[i] = buttons++;
+    {
+      m_decodeTable.AddButton(i);
+      m_traceSource.AddEvdevKey(i);
+    }
   }
   for (unsigned int i = BTN_MISC; i < KEY_MAX; i++)
   {
     if (test_bit(i, keybit))
-      m_button_bind[i] = buttons++;
+    {
+      m_decodeTable.AddButton(i);
+      m_traceSource.AddEvdevKey(i);
+    }
   }
-  SetButtonCount(m_button_bind.size());
+  SetButtonCount(m_decodeTable.ButtonCount());
 
-  unsigned int axes = 0;
   for (unsigned i = 0; i < ABS_MISC; i++)
   {
     if (test_bit(i, absbit))
@@ -315,22 +338,61 @@ bool CJoystickUdev::GetProperties()
         continue;
 
       if (abs.maximum > abs.minimum)
-        m_axes_bind[i] = { axes++, abs };
+      {
+        m_decodeTable.AddAxis(i, abs);
+        m_traceSource.AddEvdevAbs(i, abs.minimum, abs.maximum, abs.fuzz, abs.flat);
+      }
     }
   }
-  SetAxisCount(m_axes_bind.size());
+  SetAxisCount(m_decodeTable.AxisCount());
+
+  // Changes smaller than the kernel's noise estimate aren't worth reporting
+  for (unsigned int i = 0; i < ABS_MISC; i++)
+  {
+    const UdevAxisBinding* axis = m_decodeTable.GetAxis(i);
+    if (axis != nullptr && axis->epsilon > 0.0f)
+      SetAxisEpsilon(axis->axisIndex, axis->epsilon);
+  }
+
+  // Pair the axes of analog sticks for the radial deadzone
+  static const std::pair<unsigned int, unsigned int> sticks[] = {
+    { ABS_X,  ABS_Y },
+    { ABS_RX, ABS_RY },
+  };
+  for (const auto& stick : sticks)
+  {
+    const UdevAxisBinding* axisX = m_decodeTable.GetAxis(stick.first);
+    const UdevAxisBinding* axisY = m_decodeTable.GetAxis(stick.second);
+    if (axisX != nullptr && axisY != nullptr)
+      SetAnalogStick(axisX->axisIndex, axisY->axisIndex);
+  }
 
   // Check for rumble features
   if (ioctl(m_fd, EVIOCGBIT(EV_FF, sizeof(ffbit)), ffbit) >= 0)
   {
     unsigned int num_effects;
     if (ioctl(m_fd, EVIOCGEFFECTS, &num_effects) >= 0)
+    {
       SetMotorCount(std::min(num_effects, static_cast<unsigned int>(MOTOR_COUNT)));
+      m_effectCount = num_effects;
+    }
   }
 
   return true;
 }
 
+bool CJoystickUdev::AxisRestsAtMinimum(unsigned int axisIndex) const
+{
+  for (unsigned int i = 0; i < ABS_MISC; i++)
+  {
+    const UdevAxisBinding* axis = m_decodeTable.GetAxis(i);
+    if (axis != nullptr && axis->axisIndex == static_cast<int>(axisIndex))
+      return axis->bRestsAtMinimum;
+  }
+
+  return false;
+}
+
 bool CJoystickUdev::SetMotor(unsigned int motorIndex, float magnitude)
 {
 
@@ -345,9 +407,11 @@ bool CJoystickUdev::SetMotor(unsigned int motorIndex, float magnitude)
 
   uint16_t strength = std::min(0xffff, static_cast<int>(magnitude * 0xffff));
 
-  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  if (!m_rumble)
+    return false;
 
-  m_motors[motorIndex] = strength;
+  m_rumble->SetMotor(motorIndex, strength);
+  m_rumbleWorker->Notify();
 
   return true;
 }
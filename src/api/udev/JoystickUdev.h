@@ -28,12 +28,12 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "UdevDecodeTable.h"
+#include "UdevRumble.h"
 #include "api/Joystick.h"
+#include "api/replay/InputTraceRecorder.h"
 
-#include <array>
 #include <linux/input.h>
-#include <map>
-#include <mutex>
 #include <sys/types.h>
 
 struct udev_device;
@@ -45,19 +45,26 @@ namespace JOYSTICK
   public:
     enum
     {
-      MOTOR_STRONG = 0,
-      MOTOR_WEAK   = 1,
-      MOTOR_COUNT  = 2,
+      MOTOR_STRONG = CUdevRumble::MOTOR_STRONG,
+      MOTOR_WEAK   = CUdevRumble::MOTOR_WEAK,
+      MOTOR_COUNT  = CUdevRumble::MOTOR_COUNT,
     };
 
-    CJoystickUdev(udev_device* dev, const char* path);
+    /*!
+     * \param rumbleWorker The worker that applies rumble for this device
+     */
+    CJoystickUdev(udev_device* dev, const char* path, const UdevRumbleWorkerPtr& rumbleWorker);
     virtual ~CJoystickUdev(void) { Deinitialize(); }
 
     // implementation of CJoystick
     virtual bool Equals(const CJoystick* rhs) const override;
+    virtual std::string Identity(void) const override { return std::to_string(m_deviceNumber); }
     virtual bool Initialize(void) override;
     virtual void Deinitialize(void) override;
-    virtual void ProcessEvents(void) override;
+    virtual int GetPollFD(void) const override { return m_fd; }
+    virtual bool AxisRestsAtMinimum(unsigned int axisIndex) const override;
+
+    dev_t DeviceNumber(void) const { return m_deviceNumber; }
 
   protected:
     // implementation of CJoystick
@@ -65,31 +72,43 @@ namespace JOYSTICK
     bool SetMotor(unsigned int motorIndex, float magnitude);
 
   private:
-    void UpdateMotorState(const std::array<uint16_t, MOTOR_COUNT>& motors);
-    void Play(bool bPlayStop);
-
-    struct Axis
-    {
-      unsigned int  axisIndex;
-      input_absinfo axisInfo;
-    };
-
     bool OpenJoystick();
     bool GetProperties();
 
+    /*!
+     * \brief Query the full key and axis state after the kernel dropped events
+     *
+     * \param eventTimeUs The time of the SYN_REPORT ending the dropped report
+     */
+    void Resync(int64_t eventTimeUs);
+
+    /*!
+     * \brief Get the kernel timestamp of an event in microseconds of
+     *        GetMonotonicTimeUs()
+     *
+     * If the device's clock couldn't be set to CLOCK_MONOTONIC, its
+     * CLOCK_REALTIME timestamps are converted with m_realtimeOffsetUs.
+     */
+    int64_t GetEventTime(const input_event& event) const;
+
     // Udev properties
     udev_device* m_dev;
     std::string  m_path;
     dev_t        m_deviceNumber;
     int          m_fd;
     bool         m_bInitialized;
-    int          m_effect;
 
     // Joystick properties
-    std::map<unsigned int, unsigned int> m_button_bind; // Maps keycodes -> button
-    std::map<unsigned int, Axis>         m_axes_bind;   // Maps keycodes -> axis and axis info
-    std::array<uint16_t, MOTOR_COUNT>    m_motors;
-    std::array<uint16_t, MOTOR_COUNT>    m_previousMotors;
-    std::recursive_mutex m_mutex;
+    CUdevDecodeTable                     m_decodeTable;
+    bool                                 m_bDropped;     // Discarding events until the next SYN_REPORT
+    unsigned int                         m_droppedCount; // Number of SYN_DROPPED events received
+    bool                                 m_bMonotonicTime; // Event timestamps use CLOCK_MONOTONIC
+    int64_t                              m_realtimeOffsetUs; // Monotonic minus realtime clock, if not m_bMonotonicTime
+    CInputTraceSource                    m_traceSource;
+
+    // Rumble, applied asynchronously by the worker
+    unsigned int                         m_effectCount; // Number of effects the device can hold
+    UdevRumbleWorkerPtr                  m_rumbleWorker;
+    UdevRumblePtr                        m_rumble;
   };
 }
@@ -0,0 +1,169 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <linux/input.h>
+#include <stdint.h>
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Binding of an ABS code to an axis index, with its normalization
+   *        precomputed from the device's input_absinfo
+   *
+   * The extremes of the axis's range map to -1 and 1, and the rest of the
+   * range is stretched around the flat band so the output stays continuous.
+   *
+   * Most axes rest at the midpoint of their range. Values within the flat
+   * band around the midpoint map to exactly 0.
+   *
+   * Unsigned axes other than analog sticks, such as triggers, rest at their
+   * minimum. Values within the flat band above the minimum map to exactly
+   * -1. Their button maps configure the axis with center="-1" range="2".
+   */
+  struct UdevAxisBinding
+  {
+    int   axisIndex = -1;
+    float rest = 0.0f;    // Raw value at rest: the midpoint of the range, or the minimum
+    float flat = 0.0f;    // Width of the dead band on each side of the rest value, in raw units
+    float scale = 0.0f;   // Normalized units per raw unit outside the dead band
+    float epsilon = 0.0f; // Fuzz in normalized units, or 0 if unknown
+    bool  bRestsAtMinimum = false;
+
+    void SetInfo(const input_absinfo& info, bool bUnsigned)
+    {
+      const float range = static_cast<float>(info.maximum) - info.minimum;
+      const float halfRange = range / 2.0f;
+
+      bRestsAtMinimum = bUnsigned;
+
+      // Some devices report a flat as wide as the axis, so cap it to keep
+      // the axis usable
+      flat = std::min(static_cast<float>(std::max(info.flat, 0)), halfRange / 2.0f);
+
+      if (bRestsAtMinimum)
+      {
+        rest = static_cast<float>(info.minimum);
+        scale = 2.0f / (range - flat);
+      }
+      else
+      {
+        rest = (static_cast<float>(info.maximum) + info.minimum) / 2.0f;
+        scale = halfRange > 0.0f ? 1.0f / (halfRange - flat) : 0.0f;
+      }
+
+      epsilon = info.fuzz > 0 ? info.fuzz * scale : 0.0f;
+    }
+
+    float Normalize(int32_t value) const
+    {
+      float offset = value - rest;
+
+      if (bRestsAtMinimum)
+      {
+        if (offset <= flat)
+          return -1.0f;
+
+        return std::min((offset - flat) * scale - 1.0f, 1.0f);
+      }
+
+      if (offset > flat)
+        offset -= flat;
+      else if (offset < -flat)
+        offset += flat;
+      else
+        return 0.0f;
+
+      return std::max(-1.0f, std::min(offset * scale, 1.0f));
+    }
+  };
+
+  /*!
+   * \brief Direct-index tables for decoding evdev events
+   *
+   * Keycodes and ABS codes index straight into the tables, so decoding an
+   * event is a bounds check and an array load. The tables are built once
+   * when the device is opened and are read-only afterwards.
+   */
+  class CUdevDecodeTable
+  {
+  public:
+    CUdevDecodeTable(void) { Clear(); }
+
+    void Clear(void)
+    {
+      m_buttons.fill(-1);
+      m_axes.fill(UdevAxisBinding());
+      m_buttonCount = 0;
+      m_axisCount = 0;
+    }
+
+    /*!
+     * \brief Assign the next button index to a keycode
+     */
+    void AddButton(unsigned int keycode)
+    {
+      if (keycode < m_buttons.size())
+        m_buttons[keycode] = static_cast<int16_t>(m_buttonCount++);
+    }
+
+    /*!
+     * \brief Assign the next axis index to an ABS code
+     */
+    void AddAxis(unsigned int code, const input_absinfo& info)
+    {
+      if (code < m_axes.size())
+      {
+        UdevAxisBinding& axis = m_axes[code];
+        axis.axisIndex = static_cast<int>(m_axisCount++);
+        axis.SetInfo(info, info.minimum >= 0 && !IsStickAxis(code));
+      }
+    }
+
+    /*!
+     * \brief Check if an ABS code is an axis of an analog stick
+     *
+     * Many devices report their sticks as unsigned axes too, but sticks
+     * rest at the midpoint of their range.
+     */
+    static bool IsStickAxis(unsigned int code)
+    {
+      return code == ABS_X || code == ABS_Y || code == ABS_RX || code == ABS_RY;
+    }
+
+    unsigned int ButtonCount(void) const { return m_buttonCount; }
+    unsigned int AxisCount(void) const { return m_axisCount; }
+
+    /*!
+     * \brief Get the button index of a keycode, or -1 if it isn't bound
+     */
+    int GetButton(unsigned int keycode) const
+    {
+      return keycode < m_buttons.size() ? m_buttons[keycode] : -1;
+    }
+
+    /*!
+     * \brief Get the binding of an ABS code, or nullptr if it isn't bound
+     */
+    const UdevAxisBinding* GetAxis(unsigned int code) const
+    {
+      if (code < m_axes.size() && m_axes[code].axisIndex >= 0)
+        return &m_axes[code];
+      return nullptr;
+    }
+
+  private:
+    std::array<int16_t, KEY_CNT>         m_buttons; // Keycode -> button index
+    std::array<UdevAxisBinding, ABS_CNT> m_axes;    // ABS code -> axis binding
+    unsigned int m_buttonCount;
+    unsigned int m_axisCount;
+  };
+}
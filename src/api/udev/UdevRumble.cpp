@@ -0,0 +1,258 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "UdevRumble.h"
+#include "log/Log.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/input.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+using namespace JOYSTICK;
+
+#define INVALID_FD  (-1)
+
+// Minimum time between effect uploads to a device. Requests arriving faster
+// are coalesced into the next upload.
+#define RUMBLE_UPLOAD_INTERVAL  std::chrono::milliseconds(10)
+
+// --- CUdevRumble -------------------------------------------------------------
+
+CUdevRumble::CUdevRumble(int fd, const std::string& name, unsigned int effectCount) :
+  m_fd(fcntl(fd, F_DUPFD_CLOEXEC, 0)),
+  m_name(name),
+  m_motors(),
+  m_previousMotors(),
+  m_slotCount(std::max(std::min(effectCount, static_cast<unsigned int>(MAX_EFFECT_SLOTS)), 1u)),
+  m_playingSlot(-1)
+{
+  if (m_fd < 0)
+    esyslog("[udev]: Failed to duplicate descriptor for rumble on \"%s\" - %s", m_name.c_str(), strerror(errno));
+}
+
+CUdevRumble::~CUdevRumble(void)
+{
+  if (m_fd >= 0)
+  {
+    if (m_playingSlot >= 0)
+      Play(m_slots[m_playingSlot], false);
+
+    // Closing the last descriptor also frees the uploaded effects
+    close(m_fd);
+  }
+}
+
+void CUdevRumble::SetMotor(unsigned int motorIndex, uint16_t strength)
+{
+  if (motorIndex < MOTOR_COUNT)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_motors[motorIndex] = strength;
+  }
+}
+
+bool CUdevRumble::Update(TimePoint now, TimePoint& retryTime)
+{
+  if (m_fd < 0)
+    return false;
+
+  Motors motors;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    motors = m_motors;
+  }
+
+  if (motors == m_previousMotors)
+    return false;
+
+  if (now < m_lastUpload + RUMBLE_UPLOAD_INTERVAL)
+  {
+    retryTime = m_lastUpload + RUMBLE_UPLOAD_INTERVAL;
+    return true;
+  }
+
+  const bool bIsPlaying = (motors[MOTOR_STRONG] > 0 || motors[MOTOR_WEAK] > 0);
+
+  if (!bIsPlaying)
+  {
+    // Stop the effect, its slot stays allocated for the next start
+    if (m_playingSlot >= 0)
+    {
+      Play(m_slots[m_playingSlot], false);
+      m_playingSlot = -1;
+    }
+  }
+  else
+  {
+    int slotIndex = FindSlot(motors);
+    if (slotIndex < 0)
+    {
+      // Upload to the slot that isn't playing. With a single slot, the
+      // playing effect is modified in place.
+      slotIndex = m_playingSlot < 0 ? 0 : (m_playingSlot + 1) % m_slotCount;
+
+      if (!Upload(m_slots[slotIndex], motors))
+        slotIndex = -1;
+    }
+
+    if (slotIndex >= 0 && slotIndex != m_playingSlot)
+    {
+      if (m_playingSlot >= 0)
+        Play(m_slots[m_playingSlot], false);
+
+      Play(m_slots[slotIndex], true);
+      m_playingSlot = slotIndex;
+    }
+  }
+
+  m_previousMotors = motors;
+  m_lastUpload = now;
+
+  return false;
+}
+
+int CUdevRumble::FindSlot(const Motors& motors) const
+{
+  for (unsigned int i = 0; i < m_slotCount; i++)
+  {
+    if (m_slots[i].effectId >= 0 && m_slots[i].motors == motors)
+      return static_cast<int>(i);
+  }
+
+  return -1;
+}
+
+bool CUdevRumble::Upload(EffectSlot& slot, const Motors& motors)
+{
+  struct ff_effect e = { };
+
+  e.type                      = FF_RUMBLE;
+  e.id                        = slot.effectId;
+  e.u.rumble.strong_magnitude = motors[MOTOR_STRONG];
+  e.u.rumble.weak_magnitude   = motors[MOTOR_WEAK];
+
+  if (ioctl(m_fd, EVIOCSFF, &e) < 0)
+  {
+    esyslog("Failed to set rumble effect %d (0x%04x, 0x%04x) on \"%s\" - %s",
+        e.id, e.u.rumble.strong_magnitude, e.u.rumble.weak_magnitude,
+        m_name.c_str(), strerror(errno));
+    return false;
+  }
+
+  slot.effectId = e.id;
+  slot.motors = motors;
+
+  return true;
+}
+
+void CUdevRumble::Play(const EffectSlot& slot, bool bPlayStop)
+{
+  struct input_event play = { { } };
+
+  play.type  = EV_FF;
+  play.code  = slot.effectId;
+  play.value = bPlayStop;
+
+  if (write(m_fd, &play, sizeof(play)) < (ssize_t)sizeof(play))
+    esyslog("[udev]: Failed to play rumble effect %d on \"%s\" - %s", slot.effectId, m_name.c_str(), strerror(errno));
+}
+
+// --- CUdevRumbleWorker -------------------------------------------------------
+
+CUdevRumbleWorker::CUdevRumbleWorker(void) :
+  m_bPending(false),
+  m_bStop(false)
+{
+}
+
+CUdevRumbleWorker::~CUdevRumbleWorker(void)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_bStop = true;
+  }
+  m_condition.notify_one();
+
+  if (m_thread.joinable())
+    m_thread.join();
+}
+
+void CUdevRumbleWorker::Register(const UdevRumblePtr& rumble)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  m_devices.push_back(rumble);
+
+  if (!m_thread.joinable())
+    m_thread = std::thread(&CUdevRumbleWorker::Process, this);
+}
+
+void CUdevRumbleWorker::Unregister(const UdevRumblePtr& rumble)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  m_devices.erase(std::remove(m_devices.begin(), m_devices.end(), rumble), m_devices.end());
+}
+
+void CUdevRumbleWorker::Notify(void)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_bPending = true;
+  }
+  m_condition.notify_one();
+}
+
+void CUdevRumbleWorker::Process(void)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  bool bDeferred = false;
+  CUdevRumble::TimePoint retryTime;
+
+  while (!m_bStop)
+  {
+    if (bDeferred)
+      m_condition.wait_until(lock, retryTime, [this]() { return m_bPending || m_bStop; });
+    else
+      m_condition.wait(lock, [this]() { return m_bPending || m_bStop; });
+
+    if (m_bStop)
+      break;
+
+    m_bPending = false;
+
+    // Hold references so devices can be unregistered during I/O
+    std::vector<UdevRumblePtr> devices = m_devices;
+
+    lock.unlock();
+
+    const CUdevRumble::TimePoint now = std::chrono::steady_clock::now();
+
+    bDeferred = false;
+    for (const UdevRumblePtr& device : devices)
+    {
+      CUdevRumble::TimePoint deviceRetryTime;
+      if (device->Update(now, deviceRetryTime))
+      {
+        if (!bDeferred || deviceRetryTime < retryTime)
+          retryTime = deviceRetryTime;
+        bDeferred = true;
+      }
+    }
+
+    // Release references outside the lock, destroying a device does I/O
+    devices.clear();
+
+    lock.lock();
+  }
+}
@@ -0,0 +1,140 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Force-feedback state of a single udev device
+   *
+   * Motor magnitudes are requested from any thread with SetMotor(). The ioctl
+   * and write() that apply them only happen in Update(), which is called by
+   * CUdevRumbleWorker. Requests made between two updates are coalesced, so
+   * only the latest magnitudes are ever uploaded.
+   *
+   * Effects are uploaded to a small pool of kernel effect slots that stay
+   * allocated for the lifetime of the device. A new magnitude is uploaded to
+   * a slot that isn't playing, and then playback switches over to it.
+   * Starting, stopping and returning to magnitudes still held by a slot are
+   * single EV_FF writes.
+   */
+  class CUdevRumble
+  {
+  public:
+    enum
+    {
+      MOTOR_STRONG = 0,
+      MOTOR_WEAK   = 1,
+      MOTOR_COUNT  = 2,
+    };
+
+    typedef std::chrono::steady_clock::time_point TimePoint;
+
+    /*!
+     * \brief Create the rumble state for a device
+     *
+     * \param fd The device's descriptor, duplicated so that the device can be
+     *           closed while an update is in progress
+     * \param name The device's name, for logging
+     * \param effectCount The number of effects the device can hold
+     */
+    CUdevRumble(int fd, const std::string& name, unsigned int effectCount);
+    ~CUdevRumble(void);
+
+    /*!
+     * \brief Request a new magnitude for a motor. Never blocks on I/O.
+     */
+    void SetMotor(unsigned int motorIndex, uint16_t strength);
+
+    /*!
+     * \brief Apply the latest requested magnitudes. Called by the worker.
+     *
+     * \param now The current time
+     * \param retryTime (out) When to call again if the update was deferred
+     *
+     * \return true if an update is still pending and was deferred to respect
+     *         the rate limit
+     */
+    bool Update(TimePoint now, TimePoint& retryTime);
+
+  private:
+    typedef std::array<uint16_t, MOTOR_COUNT> Motors;
+
+    static const unsigned int MAX_EFFECT_SLOTS = 2;
+
+    struct EffectSlot
+    {
+      int    effectId = -1; // Kernel effect ID, or -1 if not uploaded yet
+      Motors motors = { };  // Magnitudes of the uploaded effect
+    };
+
+    int FindSlot(const Motors& motors) const;
+    bool Upload(EffectSlot& slot, const Motors& motors);
+    void Play(const EffectSlot& slot, bool bPlayStop);
+
+    const int         m_fd;
+    const std::string m_name;
+
+    // Requested state, shared with the threads calling SetMotor()
+    Motors     m_motors;
+    std::mutex m_mutex;
+
+    // Applied state, owned by the worker
+    Motors                                  m_previousMotors;
+    std::array<EffectSlot, MAX_EFFECT_SLOTS> m_slots;
+    unsigned int                            m_slotCount;
+    int                                     m_playingSlot; // Index of the playing slot, or -1
+    TimePoint                               m_lastUpload;
+  };
+
+  typedef std::shared_ptr<CUdevRumble> UdevRumblePtr;
+
+  /*!
+   * \brief Thread that applies rumble for all udev devices
+   *
+   * The thread is started when the first device is registered and stopped
+   * when the worker is destroyed.
+   */
+  class CUdevRumbleWorker
+  {
+  public:
+    CUdevRumbleWorker(void);
+    ~CUdevRumbleWorker(void);
+
+    void Register(const UdevRumblePtr& rumble);
+    void Unregister(const UdevRumblePtr& rumble);
+
+    /*!
+     * \brief Wake the worker after a device's requested magnitudes changed
+     */
+    void Notify(void);
+
+  private:
+    void Process(void);
+
+    std::vector<UdevRumblePtr> m_devices;
+    bool                       m_bPending;
+    bool                       m_bStop;
+    std::thread                m_thread;
+    std::mutex                 m_mutex;
+    std::condition_variable    m_condition;
+  };
+
+  typedef std::shared_ptr<CUdevRumbleWorker> UdevRumbleWorkerPtr;
+}
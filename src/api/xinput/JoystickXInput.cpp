@@ -34,6 +34,8 @@ CJoystickXInput::CJoystickXInput(unsigned int controllerID)
   SetHatCount(HAT_COUNT);
   SetAxisCount(AXIS_COUNT);
   SetMotorCount(MOTOR_COUNT);
+  SetAnalogStick(0, 1);
+  SetAnalogStick(2, 3);
 
   m_motorSpeeds[MOTOR_LEFT] = 0.0f;
   m_motorSpeeds[MOTOR_RIGHT] = 0.0f;
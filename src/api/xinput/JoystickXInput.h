@@ -28,6 +28,7 @@ namespace JOYSTICK
     virtual ~CJoystickXInput(void) { }
 
     virtual bool Equals(const CJoystick* rhs) const override;
+    virtual std::string Identity(void) const override { return std::to_string(m_controllerID); }
 
     virtual void PowerOff() override;
 
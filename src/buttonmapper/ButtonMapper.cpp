@@ -139,6 +139,10 @@ bool CButtonMapper::GetFeatures(const kodi::addon::Joystick& joystick, ButtonMap
   // Try to derive a button map from relations between controller profiles
   if (bNeedsFeatures)
   {
+    // Learn the relations from the button maps that haven't been looked up
+    for (const auto& database : m_databases)
+      database->ReportButtonMaps();
+
     FeatureVector derivedFeatures;
     DeriveFeatures(joystick, controllerId, buttonMap, derivedFeatures);
     MergeFeatures(features, derivedFeatures);
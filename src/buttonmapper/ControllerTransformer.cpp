@@ -52,6 +52,8 @@ CControllerTransformer::~CControllerTransformer() = default;
 
 void CControllerTransformer::OnAdd(const DevicePtr& driverInfo, const ButtonMap& buttonMap)
 {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
   // Santity check
   if (m_observedDevices.size() > 200)
     return;
@@ -76,6 +78,8 @@ DevicePtr CControllerTransformer::CreateDevice(const CDevice& deviceInfo)
 {
   DevicePtr result = std::make_shared<CDevice>(deviceInfo);
 
+  std::lock_guard<std::mutex> lock(m_mutex);
+
   for (const auto& device : m_observedDevices)
   {
     if (*device == deviceInfo)
@@ -164,6 +168,8 @@ void CControllerTransformer::TransformFeatures(const kodi::addon::Joystick& driv
                                                const FeatureVector& features,
                                                FeatureVector& transformedFeatures)
 {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
   const bool bSwap = (fromController >= toController);
 
   const unsigned int controllerFrom = m_controllerIds->RegisterString(fromController);
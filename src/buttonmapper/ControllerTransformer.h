@@ -14,6 +14,7 @@
 
 #include <kodi/addon-instance/Peripheral.h>
 
+#include <mutex>
 #include <string>
 
 namespace kodi
@@ -71,5 +72,6 @@ namespace JOYSTICK
     DeviceSet               m_observedDevices;
     CJoystickFamilyManager& m_familyManager;
     std::unique_ptr<CStringRegistry> m_controllerIds;
+    std::mutex              m_mutex; // Button maps can be reported from the warm-up thread
   };
 }
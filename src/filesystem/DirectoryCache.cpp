@@ -53,7 +53,7 @@ bool CDirectoryCache::GetDirectory(const std::string& path, std::vector<kodi::vf
     const std::chrono::steady_clock::time_point timestamp = record.first;
     const std::chrono::steady_clock::time_point expires = timestamp + DIRECTORY_LIFETIME;
 
-    if (expires <= std::chrono::steady_clock::now())
+    if (std::chrono::steady_clock::now() < expires)
     {
       items = record.second;
       return true;
@@ -96,3 +96,44 @@ void CDirectoryCache::UpdateDirectory(const std::string& path, const std::vector
   timestamp = std::chrono::steady_clock::now();
   cachedItems = items;
 }
+
+bool CDirectoryCache::AddItem(const std::string& path, const kodi::vfs::CDirEntry& item)
+{
+  if (!m_callbacks)
+    return false;
+
+  ItemList& cachedItems = m_cache[path].second;
+
+  if (HasPath(cachedItems, item.Path()))
+    return false;
+
+  cachedItems.push_back(item);
+  m_callbacks->OnAdd(item);
+
+  return true;
+}
+
+void CDirectoryCache::RemoveItem(const std::string& path, const std::string& itemPath)
+{
+  if (!m_callbacks)
+    return;
+
+  ItemMap::iterator itItemList = m_cache.find(path);
+  if (itItemList == m_cache.end())
+    return;
+
+  ItemList& cachedItems = itItemList->second.second;
+
+  ItemList::iterator itItem = std::find_if(cachedItems.begin(), cachedItems.end(),
+    [&itemPath](const kodi::vfs::CDirEntry& item)
+    {
+      return item.Path() == itemPath;
+    });
+
+  if (itItem != cachedItems.end())
+  {
+    const kodi::vfs::CDirEntry removed = *itItem;
+    cachedItems.erase(itItem);
+    m_callbacks->OnRemove(removed);
+  }
+}
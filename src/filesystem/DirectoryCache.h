@@ -33,9 +33,29 @@ namespace JOYSTICK
     void Initialize(IDirectoryCacheCallback* callbacks);
     void Deinitialize(void);
 
+    /*!
+     * \brief Get the cached listing of a directory, if it hasn't expired
+     */
     bool GetDirectory(const std::string& path, std::vector<kodi::vfs::CDirEntry>& items);
+
+    /*!
+     * \brief Replace the listing of a directory, reporting added and removed
+     *        items to the callbacks
+     */
     void UpdateDirectory(const std::string& path, const std::vector<kodi::vfs::CDirEntry>& items);
 
+    /*!
+     * \brief Add a single item to the listing of a directory
+     *
+     * \return True if the item was added, false if it was already listed
+     */
+    bool AddItem(const std::string& path, const kodi::vfs::CDirEntry& item);
+
+    /*!
+     * \brief Remove a single item from the listing of a directory
+     */
+    void RemoveItem(const std::string& path, const std::string& itemPath);
+
   private:
     IDirectoryCacheCallback* m_callbacks;
 
@@ -9,6 +9,10 @@
 #include "DirectoryUtils.h"
 #include "filesystem/vfs/VFSDirectoryUtils.h"
 
+#if defined(HAVE_INOTIFY)
+  #include "filesystem/inotify/InotifyDirectoryWatcher.h"
+#endif
+
 using namespace JOYSTICK;
 
 bool CDirectoryUtils::Initialize()
@@ -62,6 +66,21 @@ bool CDirectoryUtils::GetDirectory(const std::string& path, const std::string& m
   return false;
 }
 
+DirectoryWatcherPtr CDirectoryUtils::CreateWatcher(const std::string& path)
+{
+#if defined(HAVE_INOTIFY)
+  // Only local paths can be watched, VFS URLs must be polled
+  if (!path.empty() && path[0] == '/')
+  {
+    std::shared_ptr<CInotifyDirectoryWatcher> watcher = std::make_shared<CInotifyDirectoryWatcher>();
+    if (watcher->Initialize())
+      return watcher;
+  }
+#endif
+
+  return DirectoryWatcherPtr();
+}
+
 DirectoryUtilsPtr CDirectoryUtils::CreateDirectoryUtils(const std::string& url)
 {
   return DirectoryUtilsPtr(new CVFSDirectoryUtils());
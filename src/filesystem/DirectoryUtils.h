@@ -27,6 +27,15 @@ namespace JOYSTICK
     static bool Remove(const std::string& path);
     static bool GetDirectory(const std::string& path, const std::string& mask, std::vector<kodi::vfs::CDirEntry>& items);
 
+    /*!
+     * \brief Create a watcher that reports changes to directories under the
+     *        specified path
+     *
+     * \return The watcher, or empty if changes to the path can't be watched
+     *         and its directories must be polled instead
+     */
+    static DirectoryWatcherPtr CreateWatcher(const std::string& path);
+
   private:
     /*!
      * \brief Create a directory utility instance to handle the specified URL
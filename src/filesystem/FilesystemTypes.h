@@ -20,4 +20,7 @@ namespace JOYSTICK
 
   class IDirectoryUtils;
   typedef std::shared_ptr<IDirectoryUtils> DirectoryUtilsPtr;
+
+  class IDirectoryWatcher;
+  typedef std::shared_ptr<IDirectoryWatcher> DirectoryWatcherPtr;
 }
@@ -0,0 +1,61 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <kodi/Filesystem.h>
+
+#include <string>
+#include <vector>
+
+namespace JOYSTICK
+{
+  enum class DIRECTORY_CHANGE
+  {
+    ADDED,    // A file or folder was created or moved into the directory
+    REMOVED,  // A file or folder was deleted or moved out of the directory
+    MODIFIED, // A file was written and closed
+  };
+
+  struct DirectoryChange
+  {
+    DIRECTORY_CHANGE     type;
+    std::string          directory; // The watched directory, as passed to Watch()
+    kodi::vfs::CDirEntry item;      // Folder paths end with a slash, like VFS listings
+  };
+
+  class IDirectoryWatcher
+  {
+  public:
+    virtual ~IDirectoryWatcher(void) { }
+
+    /*!
+     * \brief Start watching a directory for changes to its items
+     *
+     * Subdirectories aren't watched. Watching a directory twice has no effect.
+     *
+     * \param path Path to the directory
+     * \return True if the directory is being watched, false otherwise
+     */
+    virtual bool Watch(const std::string& path) = 0;
+
+    /*!
+     * \brief Stop watching a directory
+     * \param path Path to the directory, as passed to Watch()
+     */
+    virtual void Unwatch(const std::string& path) = 0;
+
+    /*!
+     * \brief Get the changes since the last call. Doesn't block.
+     * \param[out] changes The changes, in the order they happened
+     * \return False if changes were lost and the watched directories must be
+     *         enumerated again, true otherwise
+     */
+    virtual bool GetChanges(std::vector<DirectoryChange>& changes) = 0;
+  };
+}
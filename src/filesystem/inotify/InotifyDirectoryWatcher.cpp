@@ -0,0 +1,178 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "InotifyDirectoryWatcher.h"
+#include "log/Log.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+using namespace JOYSTICK;
+
+// Files are reported when they're closed after writing, so that partially
+// written files aren't loaded. Folders are reported when they're created.
+#define WATCH_MASK  (IN_CREATE | IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_ONLYDIR)
+
+// Room for at least one event with the longest name
+#define EVENT_BUFFER_SIZE  (16 * (sizeof(inotify_event) + NAME_MAX + 1))
+
+bool CInotifyDirectoryWatcher::Initialize(void)
+{
+  Deinitialize();
+
+  m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (m_fd < 0)
+  {
+    esyslog("Failed to initialize inotify - %s", strerror(errno));
+    return false;
+  }
+
+  return true;
+}
+
+void CInotifyDirectoryWatcher::Deinitialize(void)
+{
+  if (m_fd >= 0)
+  {
+    // Closing the descriptor removes all watches
+    close(m_fd);
+    m_fd = -1;
+  }
+
+  m_watches.clear();
+  m_descriptors.clear();
+}
+
+bool CInotifyDirectoryWatcher::Watch(const std::string& path)
+{
+  if (m_fd < 0)
+    return false;
+
+  if (m_descriptors.find(path) != m_descriptors.end())
+    return true;
+
+  const int wd = inotify_add_watch(m_fd, path.c_str(), WATCH_MASK);
+  if (wd < 0)
+  {
+    dsyslog("Failed to watch %s - %s", path.c_str(), strerror(errno));
+    return false;
+  }
+
+  // The same directory can be reached through different paths
+  auto it = m_watches.find(wd);
+  if (it != m_watches.end())
+    m_descriptors.erase(it->second);
+
+  m_watches[wd] = path;
+  m_descriptors[path] = wd;
+
+  return true;
+}
+
+void CInotifyDirectoryWatcher::Unwatch(const std::string& path)
+{
+  auto it = m_descriptors.find(path);
+  if (it == m_descriptors.end())
+    return;
+
+  // Fails if the watch was already removed with the directory
+  inotify_rm_watch(m_fd, it->second);
+
+  m_watches.erase(it->second);
+  m_descriptors.erase(it);
+}
+
+bool CInotifyDirectoryWatcher::GetChanges(std::vector<DirectoryChange>& changes)
+{
+  if (m_fd < 0)
+    return false;
+
+  bool bComplete = true;
+
+  alignas(inotify_event) char buffer[EVENT_BUFFER_SIZE];
+
+  while (true)
+  {
+    const ssize_t len = read(m_fd, buffer, sizeof(buffer));
+    if (len < 0)
+    {
+      if (errno == EINTR)
+        continue;
+
+      if (errno != EAGAIN)
+      {
+        esyslog("Failed to read inotify events - %s", strerror(errno));
+        bComplete = false;
+      }
+      break;
+    }
+
+    for (ssize_t offset = 0; offset < len; )
+    {
+      const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+      offset += sizeof(inotify_event) + event->len;
+
+      if (event->mask & IN_Q_OVERFLOW)
+      {
+        dsyslog("Inotify queue overflowed, directories must be enumerated again");
+        bComplete = false;
+        continue;
+      }
+
+      auto it = m_watches.find(event->wd);
+      if (it == m_watches.end())
+        continue;
+
+      // The directory was deleted and its watch was removed
+      if (event->mask & IN_IGNORED)
+      {
+        m_descriptors.erase(it->second);
+        m_watches.erase(it);
+        continue;
+      }
+
+      if (event->len == 0)
+        continue;
+
+      const bool bFolder = (event->mask & IN_ISDIR) != 0;
+
+      DIRECTORY_CHANGE type;
+      if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+        type = DIRECTORY_CHANGE::REMOVED;
+      else if (event->mask & IN_MOVED_TO)
+        type = DIRECTORY_CHANGE::ADDED;
+      else if ((event->mask & IN_CREATE) && bFolder)
+        type = DIRECTORY_CHANGE::ADDED;
+      else if ((event->mask & IN_CLOSE_WRITE) && !bFolder)
+        type = DIRECTORY_CHANGE::MODIFIED;
+      else
+        continue;
+
+      const std::string& directory = it->second;
+
+      std::string path = directory;
+      if (path.empty() || path.back() != '/')
+        path += '/';
+      path += event->name;
+      if (bFolder)
+        path += '/';
+
+      DirectoryChange change;
+      change.type = type;
+      change.directory = directory;
+      change.item = kodi::vfs::CDirEntry(event->name, path, bFolder);
+
+      changes.emplace_back(std::move(change));
+    }
+  }
+
+  return bComplete;
+}
@@ -0,0 +1,44 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "filesystem/IDirectoryWatcher.h"
+
+#include <map>
+#include <string>
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Watches local directories through inotify
+   *
+   * Changes are queued by the kernel and read without blocking when
+   * GetChanges() is called, so no thread is needed.
+   */
+  class CInotifyDirectoryWatcher : public IDirectoryWatcher
+  {
+  public:
+    CInotifyDirectoryWatcher(void) = default;
+
+    virtual ~CInotifyDirectoryWatcher(void) { Deinitialize(); }
+
+    bool Initialize(void);
+    void Deinitialize(void);
+
+    // implementation of IDirectoryWatcher
+    virtual bool Watch(const std::string& path) override;
+    virtual void Unwatch(const std::string& path) override;
+    virtual bool GetChanges(std::vector<DirectoryChange>& changes) override;
+
+  private:
+    int                                m_fd = -1;
+    std::map<int, std::string>         m_watches;     // Watch descriptor -> path
+    std::map<std::string, int>         m_descriptors; // Path -> watch descriptor
+  };
+}
@@ -9,6 +9,7 @@
 #include "Settings.h"
 #include "api/JoystickManager.h"
 #include "log/Log.h"
+#include "utils/CommonMacros.h"
 
 #include <array>
 
@@ -20,10 +21,16 @@ using namespace JOYSTICK;
 #define SETTING_OSX_DRIVER          "driver_osx"
 #define SETTING_XINPUT_DRIVER       "driver_xinput"
 #define SETTING_DIRECTINPUT_DRIVER  "driver_directinput"
+#define SETTING_INPUT_REACTOR       "input_reactor"
+#define SETTING_ANALOG_DEADZONE     "analog_deadzone"
+#define SETTING_STATE_TABLE         "state_table"
+
+#define ANALOG_DEADZONE_MAX  0.5f // Must match the maximum in resources/settings.xml
 
 CSettings::CSettings(void)
   : m_bInitialized(false),
-    m_bGenerateRetroArchConfigs(false)
+    m_bGenerateRetroArchConfigs(false),
+    m_analogDeadzone(0.0f)
 {
 }
 
@@ -95,6 +102,19 @@ void CSettings::SetSetting(const std::string& strName, const kodi::CSettingValue
     CJoystickManager::Get().SetEnabled(iface, value.GetBoolean());
     CJoystickManager::Get().TriggerScan();
   }
+  else if (strName == SETTING_INPUT_REACTOR)
+  {
+    CJoystickManager::Get().SetReactorEnabled(value.GetBoolean());
+  }
+  else if (strName == SETTING_STATE_TABLE)
+  {
+    CJoystickManager::Get().SetStateTableEnabled(value.GetBoolean());
+  }
+  else if (strName == SETTING_ANALOG_DEADZONE)
+  {
+    m_analogDeadzone = CONSTRAIN(value.GetFloat(), 0.0f, ANALOG_DEADZONE_MAX);
+    dsyslog("Setting \"%s\" set to %f", SETTING_ANALOG_DEADZONE, m_analogDeadzone);
+  }
 
   m_bInitialized = true;
 }
@@ -38,8 +38,14 @@ namespace JOYSTICK
      */
     bool GenerateRetroArchConfigs(void) const { return m_bGenerateRetroArchConfigs; }
 
+    /*!
+     * \brief Radial deadzone applied to analog sticks, or 0.0 if disabled
+     */
+    float AnalogDeadzone(void) const { return m_analogDeadzone; }
+
   private:
     bool        m_bInitialized;
     bool        m_bGenerateRetroArchConfigs;
+    float       m_analogDeadzone;
   };
 }
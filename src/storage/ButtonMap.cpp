@@ -12,17 +12,15 @@
 #include "StorageManager.h"
 #include "StorageUtils.h"
 #include "buttonmapper/ButtonMapUtils.h"
+#include "filesystem/FileUtils.h"
 #include "log/Log.h"
 
 #include <kodi/addon-instance/peripheral/PeripheralUtils.h>
 
 #include <algorithm>
-#include <chrono>
 
 using namespace JOYSTICK;
 
-static constexpr std::chrono::seconds RESOURCE_LIFETIME = std::chrono::seconds(2);
-
 CButtonMap::CButtonMap(const std::string& strResourcePath, IControllerHelper *controllerHelper) :
   m_strResourcePath(strResourcePath),
   m_device(std::move(std::make_shared<CDevice>())),
@@ -80,9 +78,14 @@ bool CButtonMap::SaveButtonMap()
 {
   if (Save())
   {
-    m_timestamp = std::chrono::steady_clock::now();
+    // Don't load the file that was just saved
+    kodi::vfs::FileStatus status;
+    if (CFileUtils::Stat(m_strResourcePath, status))
+      SetLoaded(status);
+
     m_originalButtonMap.clear();
     m_bModified = false;
+    m_bHasButtonMap = true;
     return true;
   }
 
@@ -115,29 +118,79 @@ bool CButtonMap::ResetButtonMap(const std::string& controllerId)
 
 bool CButtonMap::Refresh(void)
 {
-  const std::chrono::steady_clock::time_point expires = m_timestamp + RESOURCE_LIFETIME;
-  const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  kodi::vfs::FileStatus status;
+  if (!CFileUtils::Stat(m_strResourcePath, status))
+    return false;
 
-  if (now >= expires)
-  {
-    if (!Load())
-      return false;
+  if (IsLoaded(status))
+    return true;
 
-    for (auto it = m_buttonMap.begin(); it != m_buttonMap.end(); ++it)
-    {
-      // Transfer axis configs from device configuration to features' primitives
-      m_device->Configuration().GetAxisConfigs(it->second);
+  // Record the status first, so a file that fails to load isn't loaded
+  // again until it changes
+  SetLoaded(status);
 
-      Sanitize(it->second, it->first);
-    }
+  if (!Load())
+    return false;
 
-    m_timestamp = now;
-    m_originalButtonMap.clear();
+  for (auto it = m_buttonMap.begin(); it != m_buttonMap.end(); ++it)
+  {
+    // Transfer axis configs from device configuration to features' primitives
+    m_device->Configuration().GetAxisConfigs(it->second);
+
+    Sanitize(it->second, it->first);
   }
 
+  m_originalButtonMap.clear();
+  m_bHasButtonMap = true;
+
   return true;
 }
 
+bool CButtonMap::TakeButtonMap(CButtonMap& loaded)
+{
+  if (m_bHasButtonMap || m_bModified || !loaded.m_bHasButtonMap || loaded.m_strResourcePath != m_strResourcePath)
+    return false;
+
+  m_device->Configuration() = loaded.m_device->Configuration();
+  m_buttonMap = std::move(loaded.m_buttonMap);
+  m_originalButtonMap.clear();
+  m_bHasButtonMap = true;
+
+  // Don't load the file again
+  m_bStale = loaded.m_bStale;
+  m_deviceId = loaded.m_deviceId;
+  m_fileSerialNumber = loaded.m_fileSerialNumber;
+  m_fileSize = loaded.m_fileSize;
+  m_modificationTime = loaded.m_modificationTime;
+  m_statusTime = loaded.m_statusTime;
+  m_loadTime = loaded.m_loadTime;
+
+  return true;
+}
+
+bool CButtonMap::IsLoaded(const kodi::vfs::FileStatus& status) const
+{
+  return !m_bStale &&
+         status.GetDeviceId() == m_deviceId &&
+         status.GetFileSerialNumber() == m_fileSerialNumber &&
+         status.GetSize() == m_fileSize &&
+         status.GetModificationTime() == m_modificationTime &&
+         status.GetStatusTime() == m_statusTime &&
+         m_modificationTime < m_loadTime &&
+         m_statusTime < m_loadTime;
+}
+
+void CButtonMap::SetLoaded(const kodi::vfs::FileStatus& status)
+{
+  m_bStale = false;
+  m_deviceId = status.GetDeviceId();
+  m_fileSerialNumber = status.GetFileSerialNumber();
+  m_fileSize = status.GetSize();
+  m_modificationTime = status.GetModificationTime();
+  m_statusTime = status.GetStatusTime();
+  m_loadTime = time(nullptr);
+}
+
 void CButtonMap::MergeFeature(const kodi::addon::JoystickFeature& feature, FeatureVector& features, const std::string& controllerId)
 {
   // Find existing feature with the same name being updated
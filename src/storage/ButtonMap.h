@@ -11,10 +11,12 @@
 #include "StorageTypes.h"
 #include "buttonmapper/ButtonMapTypes.h"
 
-#include <chrono>
+#include <kodi/Filesystem.h>
+
 #include <set>
 #include <stdint.h>
 #include <string>
+#include <time.h>
 
 namespace JOYSTICK
 {
@@ -34,6 +36,38 @@ namespace JOYSTICK
 
     bool IsValid(void) const;
 
+    /*!
+     * \brief Read the device record of the resource without its button map
+     *
+     * This allows resources to be indexed by device before their button maps
+     * are needed. The default implementation loads the button map too.
+     *
+     * \return False if the device record can't be read, true otherwise
+     */
+    virtual bool LoadDevice(void) { return Refresh(); }
+
+    /*!
+     * \brief Check if the button map has been loaded, or only the device
+     *        record
+     */
+    bool HasButtonMap(void) const { return m_bHasButtonMap; }
+
+    /*!
+     * \brief Check if the button map still has to be loaded from the file
+     *
+     * False if the button map was loaded, or if the file failed to load and
+     * hasn't been invalidated since.
+     */
+    bool NeedsButtonMap(void) const { return !m_bHasButtonMap && m_bStale; }
+
+    /*!
+     * \brief Take the button map of a resource that loaded the same file on
+     *        another thread
+     *
+     * \return False if this resource was loaded or modified in the meantime
+     */
+    bool TakeButtonMap(CButtonMap& loaded);
+
     const ButtonMap& GetButtonMap();
 
     void MapFeatures(const std::string& controllerId, const FeatureVector& features);
@@ -44,8 +78,22 @@ namespace JOYSTICK
 
     bool ResetButtonMap(const std::string& controllerId);
 
+    /*!
+     * \brief Load the button map if the file changed since it was last loaded
+     *
+     * The file is considered changed if its size, modification time or
+     * identity differ, or if Invalidate() was called.
+     *
+     * \return False if the file doesn't exist or fails to load, true otherwise
+     */
     bool Refresh(void);
 
+    /*!
+     * \brief Force the next refresh to load the file, e.g. after a change
+     *        was reported that the file's status might not reflect
+     */
+    void Invalidate(void) { m_bStale = true; }
+
   protected:
     virtual bool Load(void) = 0;
     virtual bool Save(void) const = 0;
@@ -64,7 +112,29 @@ namespace JOYSTICK
     ButtonMap         m_originalButtonMap;
 
   private:
-    std::chrono::steady_clock::time_point m_timestamp;
-    bool    m_bModified;
+    /*!
+     * \brief Check if the status matches the status of the loaded file
+     *
+     * File times only have a resolution of one second through the VFS. A file
+     * changed in the second it was loaded can change again without its size
+     * or times changing, so it isn't considered loaded until that second has
+     * passed.
+     */
+    bool IsLoaded(const kodi::vfs::FileStatus& status) const;
+
+    /*!
+     * \brief Record the status of the loaded file
+     */
+    void SetLoaded(const kodi::vfs::FileStatus& status);
+
+    bool     m_bModified;
+    bool     m_bHasButtonMap = false;
+    bool     m_bStale = true;
+    uint32_t m_deviceId = 0;
+    uint64_t m_fileSerialNumber = 0;
+    uint64_t m_fileSize = 0;
+    time_t   m_modificationTime = 0;
+    time_t   m_statusTime = 0;
+    time_t   m_loadTime = 0; // Time the status was recorded
   };
 }
@@ -80,6 +80,15 @@ namespace JOYSTICK
     virtual bool ResetButtonMap(const kodi::addon::Joystick& driverInfo,
                                 const std::string& controllerId) = 0;
 
+    /*!
+     * \brief Load every button map and report it to the database callbacks
+     *
+     * Lookups only load the button maps of the devices they find. This is
+     * called before a controller profile is derived, so the callbacks can
+     * learn from the rest. Button maps that are already loaded are skipped.
+     */
+    virtual void ReportButtonMaps(void) = 0;
+
     IDatabaseCallbacks* Callbacks() const { return m_callbacks; }
 
   protected:
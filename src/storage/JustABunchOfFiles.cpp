@@ -10,7 +10,9 @@
 #include "StorageDefinitions.h"
 #include "StorageUtils.h"
 #include "filesystem/DirectoryUtils.h"
+#include "filesystem/IDirectoryWatcher.h"
 #include "log/Log.h"
+#include "utils/WorkerPool.h"
 
 #include <algorithm>
 #include <kodi/tools/StringUtils.h>
@@ -18,6 +20,7 @@
 using namespace JOYSTICK;
 
 #define FOLDER_DEPTH  1  // Recurse into max 1 subdirectories (provider)
+#define MAX_WORKERS   4  // Max threads that read new resources
 
 // --- CResources --------------------------------------------------------------
 
@@ -32,10 +35,13 @@ CResources::~CResources(void)
     delete it->second;
 }
 
-DevicePtr CResources::GetDevice(const CDevice& deviceInfo) const
+DevicePtr CResources::GetDevice(const CDevice& deviceInfo)
 {
   DevicePtr device;
 
+  // Ensure the device's configuration is loaded
+  GetResource(deviceInfo, false);
+
   auto itDevice = m_devices.find(deviceInfo);
   if (itDevice != m_devices.end())
     device = itDevice->second;
@@ -43,6 +49,19 @@ DevicePtr CResources::GetDevice(const CDevice& deviceInfo) const
   return device;
 }
 
+std::vector<std::string> CResources::GetUnloadedPaths(void) const
+{
+  std::vector<std::string> resourcePaths;
+
+  for (ResourceMap::const_iterator it = m_resources.begin(); it != m_resources.end(); ++it)
+  {
+    if (it->second->NeedsButtonMap())
+      resourcePaths.push_back(it->second->Path());
+  }
+
+  return resourcePaths;
+}
+
 CButtonMap* CResources::GetResource(const CDevice& deviceInfo, bool bCreate)
 {
   CButtonMap* buttonMap = nullptr;
@@ -67,8 +86,13 @@ CButtonMap* CResources::GetResource(const CDevice& deviceInfo, bool bCreate)
   }
 
   if (itResource != m_resources.end())
+  {
     buttonMap = itResource->second;
 
+    if (!buttonMap->HasButtonMap())
+      LoadButtonMap(buttonMap);
+  }
+
   return buttonMap;
 }
 
@@ -76,8 +100,15 @@ bool CResources::AddResource(CButtonMap* resource)
 {
   if (resource != nullptr && resource->IsValid())
   {
-    CButtonMap* oldResource = m_resources[*resource->Device()];
-    delete oldResource;
+    // Keep the existing resource. It may have unsaved changes, and its
+    // button map may be referenced by a lookup.
+    auto itResource = m_resources.find(*resource->Device());
+    if (itResource != m_resources.end())
+    {
+      dsyslog("Skipping %s, device is already loaded from %s", resource->Path().c_str(), itResource->second->Path().c_str());
+      return false;
+    }
+
     m_resources[*resource->Device()] = resource;
     m_devices[*resource->Device()] = resource->Device();
     return true;
@@ -85,6 +116,22 @@ bool CResources::AddResource(CButtonMap* resource)
   return false;
 }
 
+bool CResources::MergeButtonMap(CButtonMap& loaded)
+{
+  auto itResource = m_resources.find(*loaded.Device());
+  if (itResource == m_resources.end())
+    return false;
+
+  CButtonMap* resource = itResource->second;
+  if (!resource->TakeButtonMap(loaded))
+    return false;
+
+  if (m_database->Callbacks() != nullptr)
+    m_database->Callbacks()->OnAdd(resource->Device(), resource->GetButtonMap());
+
+  return true;
+}
+
 void CResources::RemoveResource(const std::string& strPath)
 {
   for (ResourceMap::iterator it = m_resources.begin(); it != m_resources.end(); ++it)
@@ -98,7 +145,19 @@ void CResources::RemoveResource(const std::string& strPath)
   }
 }
 
-bool CResources::GetIgnoredPrimitives(const CDevice& deviceInfo, PrimitiveVector& primitives) const
+void CResources::InvalidateResource(const std::string& strPath)
+{
+  for (ResourceMap::iterator it = m_resources.begin(); it != m_resources.end(); ++it)
+  {
+    if (it->second->Path() == strPath)
+    {
+      it->second->Invalidate();
+      break;
+    }
+  }
+}
+
+bool CResources::GetIgnoredPrimitives(const CDevice& deviceInfo, PrimitiveVector& primitives)
 {
   DevicePtr device = GetDevice(deviceInfo);
   if (device)
@@ -112,16 +171,12 @@ bool CResources::GetIgnoredPrimitives(const CDevice& deviceInfo, PrimitiveVector
 
 void CResources::SetIgnoredPrimitives(const CDevice& deviceInfo, const PrimitiveVector& primitives)
 {
+  // Ensure resource exists and is loaded
+  GetResource(deviceInfo, true);
+
   auto itDevice = m_devices.find(deviceInfo);
   auto itOriginal = m_originalDevices.find(deviceInfo);
 
-  // Ensure resource exists
-  if (itDevice == m_devices.end())
-  {
-    GetResource(deviceInfo, true);
-    itDevice = m_devices.find(deviceInfo);
-  }
-
   if (itDevice != m_devices.end())
   {
     // Create a backup to allow revert
@@ -148,6 +203,15 @@ void CResources::Revert(const CDevice& deviceInfo)
   }
 }
 
+void CResources::LoadButtonMap(CButtonMap* resource)
+{
+  resource->Refresh();
+
+  // Resources that fail to load keep their device record
+  if (resource->HasButtonMap() && m_database->Callbacks() != nullptr)
+    m_database->Callbacks()->OnAdd(resource->Device(), resource->GetButtonMap());
+}
+
 // --- CJustABunchOfFiles ------------------------------------------------------
 
 CJustABunchOfFiles::CJustABunchOfFiles(const std::string& strResourcePath,
@@ -158,12 +222,15 @@ CJustABunchOfFiles::CJustABunchOfFiles(const std::string& strResourcePath,
   m_strResourcePath(strResourcePath),
   m_strExtension(strExtension),
   m_bReadWrite(bReadWrite),
+  m_workerCount(CWorkerPool::HardwareWorkerCount(MAX_WORKERS)),
   m_resources(this)
 {
   m_directoryCache.Initialize(this);
 
   if (m_bReadWrite)
     CStorageUtils::EnsureDirectoryExists(m_strResourcePath);
+
+  m_watcher = CDirectoryUtils::CreateWatcher(m_strResourcePath);
 }
 
 CJustABunchOfFiles::~CJustABunchOfFiles(void)
@@ -175,10 +242,9 @@ const ButtonMap& CJustABunchOfFiles::GetButtonMap(const kodi::addon::Joystick& d
 {
   static ButtonMap empty;
 
-  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  UpdateIndex();
 
-  // Update index
-  IndexDirectory(m_strResourcePath, FOLDER_DEPTH);
+  std::lock_guard<std::recursive_mutex> lock(m_mutex);
 
   CButtonMap* resource = m_resources.GetResource(driverInfo, false);
 
@@ -209,10 +275,9 @@ bool CJustABunchOfFiles::MapFeatures(const kodi::addon::Joystick& driverInfo,
 
 bool CJustABunchOfFiles::GetIgnoredPrimitives(const kodi::addon::Joystick& driverInfo, PrimitiveVector& primitives)
 {
-  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  UpdateIndex();
 
-  // Update index
-  IndexDirectory(m_strResourcePath, FOLDER_DEPTH);
+  std::lock_guard<std::recursive_mutex> lock(m_mutex);
 
   return m_resources.GetIgnoredPrimitives(driverInfo, primitives);
 }
@@ -282,11 +347,84 @@ bool CJustABunchOfFiles::ResetButtonMap(const kodi::addon::Joystick& driverInfo,
   return false;
 }
 
+void CJustABunchOfFiles::ReportButtonMaps(void)
+{
+  UpdateIndex();
+
+  std::vector<std::string> resourcePaths;
+
+  {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    resourcePaths = m_resources.GetUnloadedPaths();
+  }
+
+  if (!resourcePaths.empty())
+    LoadButtonMaps(resourcePaths);
+}
+
+void CJustABunchOfFiles::UpdateIndex(void)
+{
+  // Lookups wait here until the resources of an update on another thread
+  // have been added
+  std::lock_guard<std::mutex> indexLock(m_indexMutex);
+
+  std::vector<std::string> resourcePaths;
+
+  {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+    bool bEnumerate = true;
+
+    if (m_bIndexed && m_watcher)
+    {
+      std::vector<DirectoryChange> changes;
+      if (m_watcher->GetChanges(changes))
+      {
+        for (const DirectoryChange& change : changes)
+          OnChange(change);
+        bEnumerate = false;
+      }
+      else
+      {
+        // Changes were lost, enumerate everything again
+        dsyslog("Indexing %s again", m_strResourcePath.c_str());
+      }
+    }
+
+    if (bEnumerate)
+    {
+      IndexDirectory(m_strResourcePath, FOLDER_DEPTH);
+      m_bIndexed = true;
+    }
+
+    resourcePaths.swap(m_pendingResources);
+  }
+
+  if (!resourcePaths.empty())
+    LoadResources(resourcePaths);
+}
+
 void CJustABunchOfFiles::IndexDirectory(const std::string& path, unsigned int folderDepth)
 {
-  // Enumerate the directory
+  // Watch before enumerating so that no change is missed in between
+  if (m_watcher)
+  {
+    if (m_watcher->Watch(path))
+    {
+      m_watchedFolders[path] = folderDepth;
+    }
+    else
+    {
+      dsyslog("Can't watch %s, polling %s instead", path.c_str(), m_strResourcePath.c_str());
+      m_watcher.reset();
+      m_watchedFolders.clear();
+    }
+  }
+
+  // Enumerate the directory. Watched directories are only enumerated when
+  // indexing, so their cached listing is never used.
   std::vector<kodi::vfs::CDirEntry> items;
-  if (!m_directoryCache.GetDirectory(path, items))
+  if (m_watcher || !m_directoryCache.GetDirectory(path, items))
     CDirectoryUtils::GetDirectory(path, m_strExtension + "|", items);
 
   // Recurse into subdirectories
@@ -312,28 +450,130 @@ void CJustABunchOfFiles::IndexDirectory(const std::string& path, unsigned int fo
   m_directoryCache.UpdateDirectory(path, items);
 }
 
-void CJustABunchOfFiles::OnAdd(const kodi::vfs::CDirEntry& item)
+void CJustABunchOfFiles::OnChange(const DirectoryChange& change)
 {
-  if (!item.IsFolder())
+  auto itFolder = m_watchedFolders.find(change.directory);
+  if (itFolder == m_watchedFolders.end())
+    return;
+
+  const unsigned int folderDepth = itFolder->second;
+  const kodi::vfs::CDirEntry& item = change.item;
+
+  if (item.IsFolder())
   {
-    // TODO: Switch to unique_ptr or shared_ptr
-    CButtonMap* resource = CreateResource(item.Path());
+    if (folderDepth == 0)
+      return;
 
-    // Load device info
-    if (resource && resource->Refresh())
+    switch (change.type)
     {
-      if (m_resources.AddResource(resource))
-        m_callbacks->OnAdd(resource->Device(), resource->GetButtonMap());
-      else
+    case DIRECTORY_CHANGE::ADDED:
+      if (m_directoryCache.AddItem(change.directory, item))
+        IndexDirectory(item.Path(), folderDepth - 1);
+      break;
+    case DIRECTORY_CHANGE::REMOVED:
+      // Remove the folder's resources, then the folder
+      m_directoryCache.UpdateDirectory(item.Path(), std::vector<kodi::vfs::CDirEntry>());
+      m_directoryCache.RemoveItem(change.directory, item.Path());
+      if (m_watcher)
+        m_watcher->Unwatch(item.Path());
+      m_watchedFolders.erase(item.Path());
+      break;
+    default:
+      break;
+    }
+  }
+  else if (kodi::tools::StringUtils::EndsWith(item.Path(), m_strExtension))
+  {
+    switch (change.type)
+    {
+    case DIRECTORY_CHANGE::ADDED:
+    case DIRECTORY_CHANGE::MODIFIED:
+      // Known resources are loaded again on their next refresh
+      if (!m_directoryCache.AddItem(change.directory, item))
+        m_resources.InvalidateResource(item.Path());
+      break;
+    case DIRECTORY_CHANGE::REMOVED:
+      m_directoryCache.RemoveItem(change.directory, item.Path());
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+void CJustABunchOfFiles::LoadResources(const std::vector<std::string>& resourcePaths)
+{
+  std::vector<CButtonMap*> resources(resourcePaths.size());
+
+  // Load device info. The button map is loaded when the device is first
+  // looked up, unless it had to be loaded to read the device info.
+  CWorkerPool(m_workerCount).ForEach(resourcePaths.size(),
+    [this, &resourcePaths, &resources](size_t index)
+    {
+      // TODO: Switch to unique_ptr or shared_ptr
+      CButtonMap* resource = CreateResource(resourcePaths[index]);
+
+      if (resource && !resource->LoadDevice())
+      {
         delete resource;
+        resource = nullptr;
+      }
+
+      resources[index] = resource;
+    });
+
+  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+  // Add resources in the order they were indexed. Devices that were added
+  // while the files were read, e.g. by MapFeatures(), are kept.
+  for (CButtonMap* resource : resources)
+  {
+    if (resource && m_resources.AddResource(resource))
+    {
+      if (resource->HasButtonMap() && m_callbacks != nullptr)
+        m_callbacks->OnAdd(resource->Device(), resource->GetButtonMap());
     }
     else
       delete resource;
   }
 }
 
+void CJustABunchOfFiles::LoadButtonMaps(const std::vector<std::string>& resourcePaths)
+{
+  std::vector<std::unique_ptr<CButtonMap>> resources(resourcePaths.size());
+
+  // Load the files into new resources, as the indexed resources can change
+  // while the lock isn't held
+  CWorkerPool(m_workerCount).ForEach(resourcePaths.size(),
+    [this, &resourcePaths, &resources](size_t index)
+    {
+      std::unique_ptr<CButtonMap> resource(CreateResource(resourcePaths[index]));
+
+      if (resource && resource->Refresh())
+        resources[index] = std::move(resource);
+    });
+
+  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+  for (const auto& resource : resources)
+  {
+    if (resource)
+      m_resources.MergeButtonMap(*resource);
+  }
+}
+
+void CJustABunchOfFiles::OnAdd(const kodi::vfs::CDirEntry& item)
+{
+  // Loaded when the index is up to date
+  if (!item.IsFolder())
+    m_pendingResources.push_back(item.Path());
+}
+
 void CJustABunchOfFiles::OnRemove(const kodi::vfs::CDirEntry& item)
 {
+  m_pendingResources.erase(std::remove(m_pendingResources.begin(), m_pendingResources.end(), item.Path()),
+                           m_pendingResources.end());
+
   m_resources.RemoveResource(item.Path());
 }
 
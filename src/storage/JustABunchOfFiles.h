@@ -12,15 +12,18 @@
 #include "Device.h"
 #include "IDatabase.h"
 #include "filesystem/DirectoryCache.h"
+#include "filesystem/FilesystemTypes.h"
 
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 namespace JOYSTICK
 {
   class CJustABunchOfFiles;
+  struct DirectoryChange;
 
   /*!
    * \brief Container class for device records and button maps
@@ -31,18 +34,39 @@ namespace JOYSTICK
     CResources(const CJustABunchOfFiles* database);
     ~CResources(void);
 
-    DevicePtr GetDevice(const CDevice& deviceInfo) const;
+    DevicePtr GetDevice(const CDevice& deviceInfo);
+
+    /*!
+     * \brief Get the paths of resources whose button maps haven't been loaded
+     */
+    std::vector<std::string> GetUnloadedPaths(void) const;
 
     CButtonMap* GetResource(const CDevice& deviceInfo, bool bCreate);
     bool AddResource(CButtonMap* resource);
+
+    /*!
+     * \brief Move a button map loaded on another thread into the resource of
+     *        its device, and report it to the database callbacks
+     *
+     * \return False if the device's resource was removed, loaded or modified
+     *         in the meantime
+     */
+    bool MergeButtonMap(CButtonMap& loaded);
     void RemoveResource(const std::string& strPath);
+    void InvalidateResource(const std::string& strPath);
 
-    bool GetIgnoredPrimitives(const CDevice& deviceInfo, PrimitiveVector& primitives) const;
+    bool GetIgnoredPrimitives(const CDevice& deviceInfo, PrimitiveVector& primitives);
     void SetIgnoredPrimitives(const CDevice& deviceInfo, const PrimitiveVector& primitives);
 
     void Revert(const CDevice& deviceInfo);
 
   private:
+    /*!
+     * \brief Load the button map of a resource that was indexed by its device
+     *        record, and report it to the database callbacks
+     */
+    void LoadButtonMap(CButtonMap* resource);
+
     typedef std::map<CDevice, DevicePtr>   DeviceMap;
     typedef std::map<CDevice, CButtonMap*> ResourceMap;
 
@@ -77,6 +101,7 @@ namespace JOYSTICK
     virtual bool RevertButtonMap(const kodi::addon::Joystick& driverInfo) override;
     virtual bool ResetButtonMap(const kodi::addon::Joystick& driverInfo,
                                 const std::string& controllerId) override;
+    virtual void ReportButtonMaps(void) override;
 
     // implementation of IDirectoryCacheCallback
     virtual void OnAdd(const kodi::vfs::CDirEntry& item) override;
@@ -97,18 +122,64 @@ namespace JOYSTICK
 
     DevicePtr CreateDevice(const CDevice& deviceInfo) const;
 
+    /*!
+     * \brief Bring the index of the resource path up to date
+     *
+     * The first call enumerates the resource path. After that, if the path
+     * is watched, only the reported changes are applied. Otherwise, the path
+     * is enumerated again when the cached listings expire.
+     *
+     * Lookups do this first. It can be called ahead of the first lookup to
+     * warm up the index on another thread.
+     */
+    void UpdateIndex(void);
+
+    /*!
+     * \brief Set the number of threads that read new resources
+     */
+    void SetWorkerCount(unsigned int workerCount) { m_workerCount = workerCount; }
+
   private:
+
     /*!
      * \brief Recursively index a path, enumerating the folder and updating
      *        the directory cache
      */
     void IndexDirectory(const std::string& path, unsigned int folderDepth);
 
-    const std::string m_strResourcePath;
-    const std::string m_strExtension;
-    const bool        m_bReadWrite;
-    CDirectoryCache   m_directoryCache;
-    CResources        m_resources;
+    /*!
+     * \brief Apply a change reported by the directory watcher
+     */
+    void OnChange(const DirectoryChange& change);
+
+    /*!
+     * \brief Read the device records of resources added to the index
+     *
+     * The files are read concurrently, without holding the resource lock.
+     * The resources are then added under the lock, except for devices that
+     * already have a resource.
+     */
+    void LoadResources(const std::vector<std::string>& resourcePaths);
+
+    /*!
+     * \brief Load the button maps of indexed resources
+     *
+     * Like LoadResources(), the files are read concurrently without holding
+     * the resource lock, and the button maps are merged under the lock.
+     */
+    void LoadButtonMaps(const std::vector<std::string>& resourcePaths);
+
+    const std::string   m_strResourcePath;
+    const std::string   m_strExtension;
+    const bool          m_bReadWrite;
+    CDirectoryCache     m_directoryCache;
+    DirectoryWatcherPtr m_watcher; // Empty if the resource path is polled
+    std::map<std::string, unsigned int> m_watchedFolders; // Path -> remaining folder depth
+    bool                m_bIndexed = false;
+    std::vector<std::string> m_pendingResources; // Paths added to the index, loaded after indexing
+    unsigned int        m_workerCount;
+    CResources          m_resources;
+    std::mutex          m_indexMutex; // Taken before m_mutex
     std::recursive_mutex m_mutex;
   };
 }
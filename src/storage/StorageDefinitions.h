@@ -14,5 +14,7 @@
 #define RESOURCE_XML_FOLDER                    "xml"
 #define RESOURCE_RETROARCH_FOLDER              "retroarch"
 
+#define RESOURCE_BINARY_DATABASE               "buttonmaps.bin"
+
 #define DEVICES_XML_ROOT                       "devices"
 #define DEVICES_XML_ELEM_DEVICE                "device"
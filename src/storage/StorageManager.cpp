@@ -9,9 +9,14 @@
 #include "StorageManager.h"
 #include "JustABunchOfFiles.h"
 #include "StorageUtils.h"
+#include "api/Joystick.h"
+#include "api/JoystickManager.h"
 #include "buttonmapper/ButtonMapper.h"
 #include "log/Log.h"
 #include "storage/api/DatabaseJoystickAPI.h"
+#if defined(HAVE_BINARY_DATABASE)
+#include "storage/binary/DatabaseBinary.h"
+#endif
 //#include "storage/retroarch/DatabaseRetroarch.h" // TODO
 #include "storage/xml/DatabaseXml.h"
 
@@ -75,9 +80,28 @@ bool CStorageManager::Initialize(CPeripheralJoystick* peripheralLib)
   // Ensure button map path exists in user data
   CStorageUtils::EnsureDirectoryExists(strUserButtonMapPath);
 
-  m_databases.push_back(DatabasePtr(new CDatabaseXml(strUserButtonMapPath, true, m_buttonMapper->GetCallbacks(), this)));
+  // Button map folders, indexed in the background if enabled
+  std::vector<std::shared_ptr<CJustABunchOfFiles>> buttonMapFolders;
+
+  buttonMapFolders.push_back(std::make_shared<CDatabaseXml>(strUserButtonMapPath, true, m_buttonMapper->GetCallbacks(), this));
+  m_databases.push_back(buttonMapFolders.back());
   //m_databases.push_back(DatabasePtr(new CDatabaseRetroArch(strUserButtonMapPath, true, &m_controllerMapper))); // TODO
-  m_databases.push_back(DatabasePtr(new CDatabaseXml(strAddonButtonMapPath, false, m_buttonMapper->GetCallbacks(), this)));
+
+  // Prefer the add-on's button maps compiled at build time
+  bool bHasBinaryDatabase = false;
+#if defined(HAVE_BINARY_DATABASE)
+  std::unique_ptr<CDatabaseBinary> binaryDatabase(new CDatabaseBinary(strAddonButtonMapPath, m_buttonMapper->GetCallbacks(), this));
+  if (binaryDatabase->Open())
+  {
+    m_databases.push_back(DatabasePtr(binaryDatabase.release()));
+    bHasBinaryDatabase = true;
+  }
+#endif
+  if (!bHasBinaryDatabase)
+  {
+    buttonMapFolders.push_back(std::make_shared<CDatabaseXml>(strAddonButtonMapPath, false, m_buttonMapper->GetCallbacks(), this));
+    m_databases.push_back(buttonMapFolders.back());
+  }
   //m_databases.push_back(DatabasePtr(new CDatabaseRetroArch(strAddonButtonMapPath, false))); // TODO
 
   m_databases.push_back(DatabasePtr(new CDatabaseJoystickAPI(m_buttonMapper->GetCallbacks())));
@@ -87,11 +111,23 @@ bool CStorageManager::Initialize(CPeripheralJoystick* peripheralLib)
 
   m_familyManager.Initialize(strAddonPath);
 
+#if defined(HAVE_BUTTONMAP_WARMUP)
+  // Index the button map folders now, so the first device doesn't wait for it
+  m_warmupThread = std::thread([buttonMapFolders]()
+    {
+      for (const auto& database : buttonMapFolders)
+        database->UpdateIndex();
+    });
+#endif
+
   return true;
 }
 
 void CStorageManager::Deinitialize(void)
 {
+  if (m_warmupThread.joinable())
+    m_warmupThread.join();
+
   m_familyManager.Deinitialize();
   m_databases.clear();
   m_buttonMapper.reset();
@@ -104,6 +140,8 @@ void CStorageManager::GetFeatures(const kodi::addon::Joystick& joystick,
 {
   if (m_buttonMapper)
     m_buttonMapper->GetFeatures(joystick, strControllerId, features);
+
+  ConfigureTriggers(joystick, features);
 }
 
 bool CStorageManager::MapFeatures(const kodi::addon::Joystick& joystick,
@@ -174,6 +212,30 @@ void CStorageManager::RefreshButtonMaps(const std::string& strDeviceName /* = ""
     m_peripheralLib->RefreshButtonMaps(strDeviceName);
 }
 
+void CStorageManager::ConfigureTriggers(const kodi::addon::Joystick& joystick, FeatureVector& features)
+{
+  JoystickVector joysticks = CJoystickManager::Get().GetJoysticks(joystick);
+  if (joysticks.empty())
+    return;
+
+  const JoystickPtr& device = joysticks.front();
+
+  for (auto& feature : features)
+  {
+    for (auto& primitive : feature.Primitives())
+    {
+      // Triggers mapped since then are configured with their resting value
+      if (primitive.Type() == JOYSTICK_DRIVER_PRIMITIVE_TYPE_SEMIAXIS &&
+          primitive.SemiAxisDirection() == JOYSTICK_DRIVER_SEMIAXIS_POSITIVE &&
+          primitive.Center() == 0 && primitive.Range() == 1 &&
+          device->AxisRestsAtMinimum(primitive.DriverIndex()))
+      {
+        primitive = kodi::addon::DriverPrimitive(primitive.DriverIndex(), -1, JOYSTICK_DRIVER_SEMIAXIS_POSITIVE, 2);
+      }
+    }
+  }
+}
+
 JOYSTICK_FEATURE_TYPE CStorageManager::FeatureType(const std::string& strControllerId, const std::string &featureName)
 {
   if (m_peripheralLib)
@@ -15,6 +15,7 @@
 
 #include <memory>
 #include <string>
+#include <thread>
 
 class CPeripheralJoystick;
 struct AddonProps_Peripheral;
@@ -162,10 +163,20 @@ namespace JOYSTICK
     virtual JOYSTICK_FEATURE_TYPE FeatureType(const std::string& strControllerId, const std::string &featureName) override;
 
   private:
+    /*!
+     * \brief Configure the triggers of button maps saved before unsigned
+     *        axes were normalized to -1..1
+     *
+     * Those triggers rested at 0, so their positive semiaxes were mapped
+     * without an axis configuration. They now rest at -1.
+     */
+    static void ConfigureTriggers(const kodi::addon::Joystick& joystick, FeatureVector& features);
+
     CPeripheralJoystick* m_peripheralLib;
 
     DatabaseVector                 m_databases;
     std::unique_ptr<CButtonMapper> m_buttonMapper;
     CJoystickFamilyManager         m_familyManager;
+    std::thread                    m_warmupThread; // Indexes the button map folders after initialization
   };
 }
@@ -70,23 +70,6 @@ std::string CStorageUtils::RootFileName(const kodi::addon::Joystick& device)
   return filename.str();
 }
 
-int CStorageUtils::HexStringToInt(const char* strHex)
-{
-  int iVal;
-  sscanf(strHex, "%x", &iVal);
-  return iVal;
-};
-
-std::string CStorageUtils::FormatHexString(int iVal)
-{
-  if (iVal < 0)
-    iVal = 0;
-  if (iVal > 65536)
-    iVal = 65536;
-
-  return kodi::tools::StringUtils::Format("%04X", iVal);
-};
-
 std::string CStorageUtils::PrimitiveToString(const kodi::addon::DriverPrimitive& primitive)
 {
   switch (primitive.Type())
@@ -8,7 +8,9 @@
 
 #pragma once
 
+#include <kodi/tools/StringUtils.h>
 #include <set>
+#include <stdio.h>
 #include <string>
 
 namespace kodi
@@ -58,12 +60,25 @@ namespace JOYSTICK
     /*!
      * From PeripheralTypes.h of Kodi
      */
-    static int HexStringToInt(const char* strHex);
+    static int HexStringToInt(const char* strHex)
+    {
+      int iVal;
+      sscanf(strHex, "%x", &iVal);
+      return iVal;
+    }
 
     /*!
      * From PeripheralTypes.h of Kodi
      */
-    static std::string FormatHexString(int iVal);
+    static std::string FormatHexString(int iVal)
+    {
+      if (iVal < 0)
+        iVal = 0;
+      if (iVal > 65536)
+        iVal = 65536;
+
+      return kodi::tools::StringUtils::Format("%04X", iVal);
+    }
 
     static std::string PrimitiveToString(const kodi::addon::DriverPrimitive& primitive);
 
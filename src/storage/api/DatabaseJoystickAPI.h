@@ -27,5 +27,6 @@ namespace JOYSTICK
     virtual bool SaveButtonMap(const kodi::addon::Joystick& driverInfo) override;
     virtual bool RevertButtonMap(const kodi::addon::Joystick& driverInfo) override;
     virtual bool ResetButtonMap(const kodi::addon::Joystick& driverInfo, const std::string& controllerId) override;
+    virtual void ReportButtonMaps(void) override { }
   };
 }
@@ -0,0 +1,201 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "BinaryDatabaseFile.h"
+#include "log/Log.h"
+
+#include <kodi/addon-instance/peripheral/PeripheralUtils.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace JOYSTICK;
+
+namespace
+{
+  bool IsValidRange(const BinaryRange& range, uint32_t count)
+  {
+    return range.first <= count && range.count <= count - range.first;
+  }
+
+  unsigned int PrimitiveCount(EBinaryFeature layout)
+  {
+    switch (layout)
+    {
+    case EBinaryFeature::SCALAR:        return 1;
+    case EBinaryFeature::DIRECTIONAL:   return 4;
+    case EBinaryFeature::ACCELEROMETER: return 3;
+    default:
+      break;
+    }
+    return 0;
+  }
+}
+
+bool CBinaryDatabaseFile::Open(const std::string& path)
+{
+  Close();
+
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+  {
+    // The database is optional, the XML button maps are used without it
+    dsyslog("Can't open button map database %s - %s", path.c_str(), strerror(errno));
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) < 0 || st.st_size < static_cast<off_t>(sizeof(BinaryHeader)))
+  {
+    esyslog("Button map database %s is empty or unreadable", path.c_str());
+    close(fd);
+    return false;
+  }
+
+  void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  // The mapping stays valid after the descriptor is closed
+  close(fd);
+
+  if (data == MAP_FAILED)
+  {
+    esyslog("Failed to map button map database %s - %s", path.c_str(), strerror(errno));
+    return false;
+  }
+
+  m_path = path;
+  m_data = static_cast<const uint8_t*>(data);
+  m_size = static_cast<size_t>(st.st_size);
+
+  if (!Validate())
+  {
+    Close();
+    return false;
+  }
+
+  isyslog("Loaded button map database %s: %u devices", m_path.c_str(), DeviceCount());
+
+  return true;
+}
+
+void CBinaryDatabaseFile::Close(void)
+{
+  if (m_data != nullptr)
+  {
+    munmap(const_cast<uint8_t*>(m_data), m_size);
+    m_data = nullptr;
+    m_size = 0;
+  }
+
+  m_header = nullptr;
+  m_devices = nullptr;
+  m_controllers = nullptr;
+  m_features = nullptr;
+  m_primitives = nullptr;
+  m_axes = nullptr;
+  m_buttons = nullptr;
+  m_strings = nullptr;
+}
+
+template<typename T>
+bool CBinaryDatabaseFile::MapArray(const BinaryRange& range, const T*& array) const
+{
+  if (range.first % BINARY_DATABASE_ALIGNMENT != 0 ||
+      range.first > m_size ||
+      range.count > (m_size - range.first) / sizeof(T))
+  {
+    return false;
+  }
+
+  array = reinterpret_cast<const T*>(m_data + range.first);
+
+  return true;
+}
+
+bool CBinaryDatabaseFile::Validate(void)
+{
+  m_header = reinterpret_cast<const BinaryHeader*>(m_data);
+  if (m_header->magic != BINARY_DATABASE_MAGIC || m_header->version != BINARY_DATABASE_VERSION)
+  {
+    esyslog("Button map database %s has an unsupported format", m_path.c_str());
+    return false;
+  }
+
+  if (!MapArray(m_header->devices, m_devices) ||
+      !MapArray(m_header->controllers, m_controllers) ||
+      !MapArray(m_header->features, m_features) ||
+      !MapArray(m_header->primitives, m_primitives) ||
+      !MapArray(m_header->axes, m_axes) ||
+      !MapArray(m_header->buttons, m_buttons) ||
+      !MapArray(m_header->strings, m_strings))
+  {
+    esyslog("Button map database %s is truncated", m_path.c_str());
+    return false;
+  }
+
+  // Every string must be terminated inside the table
+  if (m_header->strings.count == 0 || m_strings[m_header->strings.count - 1] != '\0')
+  {
+    esyslog("Button map database %s has an invalid string table", m_path.c_str());
+    return false;
+  }
+
+  // Check all references once, so records can be read without checks
+  for (unsigned int i = 0; i < m_header->devices.count; i++)
+  {
+    const BinaryDevice& device = m_devices[i];
+    if (!IsValidString(device.name) ||
+        !IsValidString(device.provider) ||
+        !IsValidRange(device.controllers, m_header->controllers.count) ||
+        !IsValidRange(device.axes, m_header->axes.count) ||
+        !IsValidRange(device.buttons, m_header->buttons.count))
+    {
+      esyslog("Button map database %s has an invalid device record", m_path.c_str());
+      return false;
+    }
+  }
+
+  for (unsigned int i = 0; i < m_header->controllers.count; i++)
+  {
+    const BinaryController& controller = m_controllers[i];
+    if (!IsValidString(controller.id) ||
+        !IsValidRange(controller.features, m_header->features.count))
+    {
+      esyslog("Button map database %s has an invalid controller record", m_path.c_str());
+      return false;
+    }
+  }
+
+  for (unsigned int i = 0; i < m_header->features.count; i++)
+  {
+    const BinaryFeature& feature = m_features[i];
+    if (!IsValidString(feature.name) ||
+        !IsValidRange(feature.primitives, m_header->primitives.count) ||
+        feature.primitives.count != PrimitiveCount(static_cast<EBinaryFeature>(feature.layout)))
+    {
+      esyslog("Button map database %s has an invalid feature record", m_path.c_str());
+      return false;
+    }
+  }
+
+  for (unsigned int i = 0; i < m_header->primitives.count; i++)
+  {
+    const BinaryPrimitive& primitive = m_primitives[i];
+    if (primitive.type == JOYSTICK_DRIVER_PRIMITIVE_TYPE_KEY && !IsValidString(primitive.index))
+    {
+      esyslog("Button map database %s has an invalid primitive record", m_path.c_str());
+      return false;
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,72 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "BinaryDatabaseFormat.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Read-only view of a binary button map database
+   *
+   * The file is mapped into memory and validated once when opened. Records
+   * are read in place and are valid until the database is closed.
+   */
+  class CBinaryDatabaseFile
+  {
+  public:
+    CBinaryDatabaseFile(void) = default;
+    ~CBinaryDatabaseFile(void) { Close(); }
+
+    bool Open(const std::string& path);
+    void Close(void);
+
+    bool IsOpen(void) const { return m_data != nullptr; }
+
+    const std::string& Path(void) const { return m_path; }
+
+    unsigned int DeviceCount(void) const { return m_header != nullptr ? m_header->devices.count : 0; }
+
+    const BinaryDevice&       Device(unsigned int index) const       { return m_devices[index]; }
+    const BinaryController&   Controller(unsigned int index) const   { return m_controllers[index]; }
+    const BinaryFeature&      Feature(unsigned int index) const      { return m_features[index]; }
+    const BinaryPrimitive&    Primitive(unsigned int index) const    { return m_primitives[index]; }
+    const BinaryAxisConfig&   AxisConfig(unsigned int index) const   { return m_axes[index]; }
+    const BinaryButtonConfig& ButtonConfig(unsigned int index) const { return m_buttons[index]; }
+
+    /*!
+     * \brief Get a string from the string table
+     */
+    const char* String(uint32_t offset) const { return m_strings + offset; }
+
+  private:
+    bool Validate(void);
+
+    template<typename T>
+    bool MapArray(const BinaryRange& range, const T*& array) const;
+
+    bool IsValidString(uint32_t offset) const { return offset < m_header->strings.count; }
+
+    std::string               m_path;
+    const uint8_t*            m_data = nullptr;
+    size_t                    m_size = 0;
+    const BinaryHeader*       m_header = nullptr;
+    const BinaryDevice*       m_devices = nullptr;
+    const BinaryController*   m_controllers = nullptr;
+    const BinaryFeature*      m_features = nullptr;
+    const BinaryPrimitive*    m_primitives = nullptr;
+    const BinaryAxisConfig*   m_axes = nullptr;
+    const BinaryButtonConfig* m_buttons = nullptr;
+    const char*               m_strings = nullptr;
+  };
+}
@@ -0,0 +1,135 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace JOYSTICK
+{
+  /*
+   * Binary button map database format
+   *
+   * The database is compiled from the add-on's XML button maps at build time
+   * and read in place after the file is mapped into memory. A BinaryHeader is
+   * followed by flat arrays of records that refer to each other by index:
+   *
+   *   devices -> controllers -> features -> primitives
+   *   devices -> axis configs, button configs
+   *
+   * All strings are interned in a single string table of null-terminated
+   * strings and referred to by their offset in the table.
+   *
+   * Devices are sorted in the order of CDevice::operator<(), so a device can
+   * be found with a binary search.
+   *
+   * Fields are stored in host byte order. A database compiled on a machine of
+   * different endianness is rejected because its magic doesn't match.
+   */
+
+  #define BINARY_DATABASE_MAGIC      0x4d424a4b // "KJBM"
+  #define BINARY_DATABASE_VERSION    1
+  #define BINARY_DATABASE_ALIGNMENT  4
+
+  /*!
+   * \brief Layout of a feature's primitives
+   *
+   * The feature type of directional features depends on the controller
+   * profile (analog stick, relative pointer, wheel or throttle), so it's
+   * resolved when the button map is loaded.
+   */
+  enum class EBinaryFeature : uint8_t
+  {
+    SCALAR        = 1, // One primitive
+    DIRECTIONAL   = 2, // Up, down, right, left
+    ACCELEROMETER = 3, // Positive X, positive Y, positive Z
+  };
+
+  struct BinaryRange
+  {
+    uint32_t first; // Index of the first record
+    uint32_t count;
+  };
+
+  /*!
+   * \brief File header. The ranges hold the byte offset of each array and
+   *        its number of records, or the size in bytes of the string table.
+   */
+  struct BinaryHeader
+  {
+    uint32_t    magic;
+    uint16_t    version;
+    uint16_t    reserved;
+    BinaryRange devices;
+    BinaryRange controllers;
+    BinaryRange features;
+    BinaryRange primitives;
+    BinaryRange axes;
+    BinaryRange buttons;
+    BinaryRange strings;
+  };
+
+  struct BinaryDevice
+  {
+    uint32_t    name;       // String offset
+    uint32_t    provider;   // String offset
+    uint16_t    vendorId;
+    uint16_t    productId;
+    uint16_t    buttonCount;
+    uint16_t    hatCount;
+    uint16_t    axisCount;
+    uint16_t    reserved;
+    uint32_t    index;
+    BinaryRange controllers;
+    BinaryRange axes;
+    BinaryRange buttons;
+  };
+
+  struct BinaryController
+  {
+    uint32_t    id;         // String offset
+    BinaryRange features;
+  };
+
+  struct BinaryFeature
+  {
+    uint32_t    name;       // String offset
+    uint8_t     layout;     // EBinaryFeature
+    uint8_t     reserved[3];
+    BinaryRange primitives;
+  };
+
+  struct BinaryPrimitive
+  {
+    uint8_t     type;       // JOYSTICK_DRIVER_PRIMITIVE_TYPE, unknown for unmapped directions
+    int8_t      direction;  // Hat, semiaxis or relative pointer direction
+    uint16_t    reserved;
+    uint32_t    index;      // Driver index, mouse button, or string offset of the keycode
+  };
+
+  struct BinaryAxisConfig
+  {
+    uint32_t    index;
+    int32_t     center;
+    uint32_t    range;
+    uint8_t     bIgnore;
+    uint8_t     reserved[3];
+  };
+
+  struct BinaryButtonConfig
+  {
+    uint32_t    index;
+    uint8_t     bIgnore;
+    uint8_t     reserved[3];
+  };
+
+  static_assert(sizeof(BinaryHeader) % BINARY_DATABASE_ALIGNMENT == 0, "Invalid database header size");
+  static_assert(sizeof(BinaryDevice) == 48, "Invalid device record size");
+  static_assert(sizeof(BinaryPrimitive) == 8, "Invalid primitive record size");
+}
@@ -0,0 +1,203 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "ButtonMapBinary.h"
+#include "BinaryDatabaseFile.h"
+#include "storage/Device.h"
+#include "storage/StorageManager.h"
+#include "log/Log.h"
+
+#include <kodi/addon-instance/peripheral/PeripheralUtils.h>
+
+#include <utility>
+
+using namespace JOYSTICK;
+
+CButtonMapBinary::CButtonMapBinary(const CBinaryDatabaseFile& database, const BinaryDevice& record, IControllerHelper *controllerHelper) :
+  CButtonMap(database.Path(), controllerHelper),
+  m_database(database),
+  m_record(record)
+{
+  Deserialize(m_database, m_record, *m_device);
+}
+
+void CButtonMapBinary::Deserialize(const CBinaryDatabaseFile& database, const BinaryDevice& record, CDevice& device)
+{
+  device.Reset();
+
+  device.SetName(database.String(record.name));
+  device.SetProvider(database.String(record.provider));
+  device.SetVendorID(record.vendorId);
+  device.SetProductID(record.productId);
+  device.SetButtonCount(record.buttonCount);
+  device.SetHatCount(record.hatCount);
+  device.SetAxisCount(record.axisCount);
+  device.SetIndex(record.index);
+
+  CDeviceConfiguration& config = device.Configuration();
+
+  for (uint32_t i = 0; i < record.axes.count; i++)
+  {
+    const BinaryAxisConfig& axis = database.AxisConfig(record.axes.first + i);
+
+    AxisConfiguration axisConfig;
+    axisConfig.trigger.center = axis.center;
+    axisConfig.trigger.range = axis.range;
+    axisConfig.bIgnore = (axis.bIgnore != 0);
+
+    config.SetAxis(axis.index, axisConfig);
+  }
+
+  for (uint32_t i = 0; i < record.buttons.count; i++)
+  {
+    const BinaryButtonConfig& button = database.ButtonConfig(record.buttons.first + i);
+
+    ButtonConfiguration buttonConfig;
+    buttonConfig.bIgnore = (button.bIgnore != 0);
+
+    config.SetButton(button.index, buttonConfig);
+  }
+}
+
+bool CButtonMapBinary::Load(void)
+{
+  // Don't overwrite valid device
+  if (!m_device->IsValid())
+    Deserialize(m_database, m_record, *m_device);
+
+  // For logging purposes
+  unsigned int totalFeatureCount = 0;
+
+  for (uint32_t i = 0; i < m_record.controllers.count; i++)
+  {
+    const BinaryController& controller = m_database.Controller(m_record.controllers.first + i);
+
+    FeatureVector features;
+    Deserialize(controller, features);
+
+    totalFeatureCount += static_cast<unsigned int>(features.size());
+    m_buttonMap[m_database.String(controller.id)] = std::move(features);
+  }
+
+  dsyslog("Loaded device \"%s\" with %u controller profiles and %u total features", m_device->Name().c_str(), m_buttonMap.size(), totalFeatureCount);
+
+  return true;
+}
+
+void CButtonMapBinary::Deserialize(const BinaryController& controller, FeatureVector& features) const
+{
+  const std::string controllerId = m_database.String(controller.id);
+
+  features.reserve(controller.features.count);
+
+  for (uint32_t i = 0; i < controller.features.count; i++)
+  {
+    const BinaryFeature& record = m_database.Feature(controller.features.first + i);
+    const BinaryPrimitive* primitives = &m_database.Primitive(record.primitives.first);
+
+    const std::string strName = m_database.String(record.name);
+
+    switch (static_cast<EBinaryFeature>(record.layout))
+    {
+      case EBinaryFeature::SCALAR:
+      {
+        kodi::addon::JoystickFeature feature(strName, JOYSTICK_FEATURE_TYPE_SCALAR);
+        feature.SetPrimitive(JOYSTICK_SCALAR_PRIMITIVE, Deserialize(primitives[0]));
+        features.emplace_back(std::move(feature));
+        break;
+      }
+      case EBinaryFeature::DIRECTIONAL:
+      {
+        // Primitives are stored as up, down, right, left
+        const JOYSTICK_FEATURE_TYPE type = m_controllerHelper->FeatureType(controllerId, strName);
+
+        kodi::addon::JoystickFeature feature(strName, type);
+
+        switch (type)
+        {
+          case JOYSTICK_FEATURE_TYPE_ANALOG_STICK:
+          {
+            feature.SetPrimitive(JOYSTICK_ANALOG_STICK_UP, Deserialize(primitives[0]));
+            feature.SetPrimitive(JOYSTICK_ANALOG_STICK_DOWN, Deserialize(primitives[1]));
+            feature.SetPrimitive(JOYSTICK_ANALOG_STICK_RIGHT, Deserialize(primitives[2]));
+            feature.SetPrimitive(JOYSTICK_ANALOG_STICK_LEFT, Deserialize(primitives[3]));
+            break;
+          }
+          case JOYSTICK_FEATURE_TYPE_RELPOINTER:
+          {
+            feature.SetPrimitive(JOYSTICK_RELPOINTER_UP, Deserialize(primitives[0]));
+            feature.SetPrimitive(JOYSTICK_RELPOINTER_DOWN, Deserialize(primitives[1]));
+            feature.SetPrimitive(JOYSTICK_RELPOINTER_RIGHT, Deserialize(primitives[2]));
+            feature.SetPrimitive(JOYSTICK_RELPOINTER_LEFT, Deserialize(primitives[3]));
+            break;
+          }
+          case JOYSTICK_FEATURE_TYPE_WHEEL:
+          {
+            feature.SetPrimitive(JOYSTICK_WHEEL_RIGHT, Deserialize(primitives[2]));
+            feature.SetPrimitive(JOYSTICK_WHEEL_LEFT, Deserialize(primitives[3]));
+            break;
+          }
+          case JOYSTICK_FEATURE_TYPE_THROTTLE:
+          {
+            feature.SetPrimitive(JOYSTICK_THROTTLE_UP, Deserialize(primitives[0]));
+            feature.SetPrimitive(JOYSTICK_THROTTLE_DOWN, Deserialize(primitives[1]));
+            break;
+          }
+          default:
+            break;
+        }
+
+        features.emplace_back(std::move(feature));
+        break;
+      }
+      case EBinaryFeature::ACCELEROMETER:
+      {
+        kodi::addon::JoystickFeature feature(strName, JOYSTICK_FEATURE_TYPE_ACCELEROMETER);
+        feature.SetPrimitive(JOYSTICK_ACCELEROMETER_POSITIVE_X, Deserialize(primitives[0]));
+        feature.SetPrimitive(JOYSTICK_ACCELEROMETER_POSITIVE_Y, Deserialize(primitives[1]));
+        feature.SetPrimitive(JOYSTICK_ACCELEROMETER_POSITIVE_Z, Deserialize(primitives[2]));
+        features.emplace_back(std::move(feature));
+        break;
+      }
+      default:
+        break;
+    }
+  }
+}
+
+kodi::addon::DriverPrimitive CButtonMapBinary::Deserialize(const BinaryPrimitive& primitive) const
+{
+  switch (static_cast<JOYSTICK_DRIVER_PRIMITIVE_TYPE>(primitive.type))
+  {
+    case JOYSTICK_DRIVER_PRIMITIVE_TYPE_BUTTON:
+      return kodi::addon::DriverPrimitive::CreateButton(primitive.index);
+
+    case JOYSTICK_DRIVER_PRIMITIVE_TYPE_HAT_DIRECTION:
+      return kodi::addon::DriverPrimitive(primitive.index, static_cast<JOYSTICK_DRIVER_HAT_DIRECTION>(primitive.direction));
+
+    case JOYSTICK_DRIVER_PRIMITIVE_TYPE_SEMIAXIS:
+      return kodi::addon::DriverPrimitive(primitive.index, 0, static_cast<JOYSTICK_DRIVER_SEMIAXIS_DIRECTION>(primitive.direction), 1);
+
+    case JOYSTICK_DRIVER_PRIMITIVE_TYPE_MOTOR:
+      return kodi::addon::DriverPrimitive::CreateMotor(primitive.index);
+
+    case JOYSTICK_DRIVER_PRIMITIVE_TYPE_KEY:
+      return kodi::addon::DriverPrimitive(std::string(m_database.String(primitive.index)));
+
+    case JOYSTICK_DRIVER_PRIMITIVE_TYPE_MOUSE_BUTTON:
+      return kodi::addon::DriverPrimitive::CreateMouseButton(static_cast<JOYSTICK_DRIVER_MOUSE_INDEX>(primitive.index));
+
+    case JOYSTICK_DRIVER_PRIMITIVE_TYPE_RELPOINTER_DIRECTION:
+      return kodi::addon::DriverPrimitive(static_cast<JOYSTICK_DRIVER_RELPOINTER_DIRECTION>(primitive.direction));
+
+    default:
+      break;
+  }
+
+  return kodi::addon::DriverPrimitive();
+}
@@ -0,0 +1,62 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "storage/ButtonMap.h"
+
+#include <string>
+
+namespace kodi
+{
+namespace addon
+{
+  struct DriverPrimitive;
+}
+}
+
+namespace JOYSTICK
+{
+  class CBinaryDatabaseFile;
+  class IControllerHelper;
+  struct BinaryController;
+  struct BinaryDevice;
+  struct BinaryPrimitive;
+
+  /*!
+   * \brief Button map of a device in the binary button map database
+   *
+   * The database is read-only, so the button map can't be saved.
+   */
+  class CButtonMapBinary : public CButtonMap
+  {
+  public:
+    CButtonMapBinary(const CBinaryDatabaseFile& database, const BinaryDevice& record, IControllerHelper *controllerHelper);
+
+    virtual ~CButtonMapBinary(void) { }
+
+    /*!
+     * \brief Read a device record, including its configuration
+     */
+    static void Deserialize(const CBinaryDatabaseFile& database, const BinaryDevice& record, CDevice& device);
+
+  protected:
+    // implementation of CButtonMap
+    virtual bool Load(void) override;
+    virtual bool Save(void) const override { return false; }
+
+  private:
+    void Deserialize(const BinaryController& controller, FeatureVector& features) const;
+
+    kodi::addon::DriverPrimitive Deserialize(const BinaryPrimitive& primitive) const;
+
+    // Construction parameters
+    const CBinaryDatabaseFile& m_database;
+    const BinaryDevice&        m_record;
+  };
+}
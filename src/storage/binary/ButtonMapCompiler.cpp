@@ -0,0 +1,468 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+/*
+ * Compiles the add-on's XML button maps into a binary database
+ *
+ * Runs on the build machine as part of the build. Button maps are read with
+ * the same deserializers as CButtonMapXml, and files it would reject are
+ * skipped with a warning.
+ *
+ * Usage:
+ *
+ *   buttonmap_compiler <xml folder> <database file>
+ */
+
+#include "BinaryDatabaseFormat.h"
+#include "storage/Device.h"
+#include "storage/StorageDefinitions.h"
+#include "storage/StorageManager.h"
+#include "storage/xml/ButtonMapDefinitions.h"
+#include "storage/xml/ControllerXml.h"
+#include "storage/xml/DeviceXml.h"
+
+#include <kodi/addon-instance/peripheral/PeripheralUtils.h>
+#include <tinyxml.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <map>
+#include <string>
+#include <sys/stat.h>
+#include <utility>
+#include <vector>
+
+using namespace JOYSTICK;
+
+#define FOLDER_DEPTH  1  // Recurse into max 1 subdirectories (provider)
+
+namespace
+{
+  struct CompiledDevice
+  {
+    std::string path; // For diagnostics
+    CDevice     device;
+    ButtonMap   buttonMap;
+  };
+
+  /*!
+   * \brief Directional features are compiled with all four directions
+   *
+   * Their feature type depends on the controller profile, which isn't known
+   * at build time. It's resolved when the button map is loaded, and an analog
+   * stick holds the primitives of every directional type.
+   */
+  class CCompilerControllerHelper : public IControllerHelper
+  {
+  public:
+    virtual JOYSTICK_FEATURE_TYPE FeatureType(const std::string& strControllerId, const std::string &featureName) override
+    {
+      return JOYSTICK_FEATURE_TYPE_ANALOG_STICK;
+    }
+  };
+
+  class CButtonMapCompiler
+  {
+  public:
+    /*!
+     * \brief Add the button maps in a folder and its subfolders
+     */
+    void AddFolder(const std::string& path, unsigned int folderDepth);
+
+    /*!
+     * \brief Add the button map in a file
+     *
+     * \return False if the file was rejected, true otherwise
+     */
+    bool AddFile(const std::string& path);
+
+    /*!
+     * \brief Write the database
+     */
+    bool Write(const std::string& path);
+
+    unsigned int DeviceCount(void) const { return static_cast<unsigned int>(m_devices.size()); }
+    unsigned int RejectedCount(void) const { return m_rejectedCount; }
+
+  private:
+    /*!
+     * \brief Get the layout and primitives of a feature
+     *
+     * \return False if the feature type can't be compiled
+     */
+    static bool GetLayout(const kodi::addon::JoystickFeature& feature, EBinaryFeature& layout, std::vector<kodi::addon::DriverPrimitive>& primitives);
+
+    uint32_t Intern(const std::string& str);
+    BinaryPrimitive Compile(const kodi::addon::DriverPrimitive& primitive);
+
+    std::vector<CompiledDevice>     m_devices;
+    unsigned int                    m_rejectedCount = 0;
+    std::string                     m_strings;
+    std::map<std::string, uint32_t> m_stringOffsets;
+    CCompilerControllerHelper       m_controllerHelper;
+  };
+
+  void CButtonMapCompiler::AddFolder(const std::string& path, unsigned int folderDepth)
+  {
+    DIR* dir = opendir(path.c_str());
+    if (dir == nullptr)
+    {
+      fprintf(stderr, "warning: can't open %s\n", path.c_str());
+      return;
+    }
+
+    std::vector<std::string> names;
+    while (const dirent* entry = readdir(dir))
+    {
+      if (entry->d_name[0] != '.')
+        names.emplace_back(entry->d_name);
+    }
+    closedir(dir);
+
+    // Keep the output reproducible
+    std::sort(names.begin(), names.end());
+
+    for (const std::string& name : names)
+    {
+      const std::string itemPath = path + "/" + name;
+
+      struct stat st;
+      if (stat(itemPath.c_str(), &st) != 0)
+        continue;
+
+      if (S_ISDIR(st.st_mode))
+      {
+        if (folderDepth > 0)
+          AddFolder(itemPath, folderDepth - 1);
+      }
+      else if (name.size() > std::strlen(RESOURCE_XML_EXTENSION) &&
+               name.compare(name.size() - std::strlen(RESOURCE_XML_EXTENSION), std::string::npos, RESOURCE_XML_EXTENSION) == 0)
+      {
+        if (!AddFile(itemPath))
+        {
+          fprintf(stderr, "warning: skipping %s\n", itemPath.c_str());
+          m_rejectedCount++;
+        }
+      }
+    }
+  }
+
+  bool CButtonMapCompiler::AddFile(const std::string& path)
+  {
+    TiXmlDocument xmlFile;
+    if (!xmlFile.LoadFile(path))
+    {
+      fprintf(stderr, "%s: %s\n", path.c_str(), xmlFile.ErrorDesc());
+      return false;
+    }
+
+    const TiXmlElement* pRootElement = xmlFile.RootElement();
+    if (!pRootElement || pRootElement->NoChildren() || pRootElement->ValueStr() != BUTTONMAP_XML_ROOT)
+    {
+      fprintf(stderr, "%s: can't find root <%s> tag\n", path.c_str(), BUTTONMAP_XML_ROOT);
+      return false;
+    }
+
+    const TiXmlElement* pDevice = pRootElement->FirstChildElement(BUTTONMAP_XML_ELEM_DEVICE);
+    if (!pDevice)
+    {
+      fprintf(stderr, "%s: can't find <%s> tag\n", path.c_str(), BUTTONMAP_XML_ELEM_DEVICE);
+      return false;
+    }
+
+    CompiledDevice device;
+    device.path = path;
+
+    if (!CDeviceXml::Deserialize(pDevice, device.device))
+      return false;
+
+    // Like CButtonMapXml, keep the device's configuration if its controller
+    // profiles can't be loaded
+    if (!CControllerXml::DeserializeButtonMap(pDevice, device.buttonMap, &m_controllerHelper))
+    {
+      fprintf(stderr, "warning: %s: no controller profiles loaded\n", path.c_str());
+      device.buttonMap.clear();
+    }
+
+    m_devices.emplace_back(std::move(device));
+
+    return true;
+  }
+
+  bool CButtonMapCompiler::GetLayout(const kodi::addon::JoystickFeature& feature, EBinaryFeature& layout, std::vector<kodi::addon::DriverPrimitive>& primitives)
+  {
+    switch (feature.Type())
+    {
+    case JOYSTICK_FEATURE_TYPE_SCALAR:
+      layout = EBinaryFeature::SCALAR;
+      primitives = { feature.Primitive(JOYSTICK_SCALAR_PRIMITIVE) };
+      return true;
+    case JOYSTICK_FEATURE_TYPE_ANALOG_STICK:
+      // Stored as up, down, right, left
+      layout = EBinaryFeature::DIRECTIONAL;
+      primitives = {
+        feature.Primitive(JOYSTICK_ANALOG_STICK_UP),
+        feature.Primitive(JOYSTICK_ANALOG_STICK_DOWN),
+        feature.Primitive(JOYSTICK_ANALOG_STICK_RIGHT),
+        feature.Primitive(JOYSTICK_ANALOG_STICK_LEFT),
+      };
+      return true;
+    case JOYSTICK_FEATURE_TYPE_ACCELEROMETER:
+      layout = EBinaryFeature::ACCELEROMETER;
+      primitives = {
+        feature.Primitive(JOYSTICK_ACCELEROMETER_POSITIVE_X),
+        feature.Primitive(JOYSTICK_ACCELEROMETER_POSITIVE_Y),
+        feature.Primitive(JOYSTICK_ACCELEROMETER_POSITIVE_Z),
+      };
+      return true;
+    default:
+      break;
+    }
+
+    return false;
+  }
+
+  uint32_t CButtonMapCompiler::Intern(const std::string& str)
+  {
+    auto it = m_stringOffsets.find(str);
+    if (it != m_stringOffsets.end())
+      return it->second;
+
+    const uint32_t offset = static_cast<uint32_t>(m_strings.size());
+    m_strings.append(str.c_str(), str.size() + 1);
+    m_stringOffsets[str] = offset;
+
+    return offset;
+  }
+
+  BinaryPrimitive CButtonMapCompiler::Compile(const kodi::addon::DriverPrimitive& primitive)
+  {
+    BinaryPrimitive record{ };
+    record.type = static_cast<uint8_t>(primitive.Type());
+
+    switch (primitive.Type())
+    {
+    case JOYSTICK_DRIVER_PRIMITIVE_TYPE_BUTTON:
+    case JOYSTICK_DRIVER_PRIMITIVE_TYPE_MOTOR:
+      record.index = primitive.DriverIndex();
+      break;
+    case JOYSTICK_DRIVER_PRIMITIVE_TYPE_HAT_DIRECTION:
+      record.index = primitive.DriverIndex();
+      record.direction = static_cast<int8_t>(primitive.HatDirection());
+      break;
+    case JOYSTICK_DRIVER_PRIMITIVE_TYPE_SEMIAXIS:
+      // Center and range come from the device configuration
+      record.index = primitive.DriverIndex();
+      record.direction = static_cast<int8_t>(primitive.SemiAxisDirection());
+      break;
+    case JOYSTICK_DRIVER_PRIMITIVE_TYPE_KEY:
+      record.index = Intern(primitive.Keycode());
+      break;
+    case JOYSTICK_DRIVER_PRIMITIVE_TYPE_MOUSE_BUTTON:
+      record.index = static_cast<uint32_t>(primitive.MouseIndex());
+      break;
+    case JOYSTICK_DRIVER_PRIMITIVE_TYPE_RELPOINTER_DIRECTION:
+      record.direction = static_cast<int8_t>(primitive.RelPointerDirection());
+      break;
+    default:
+      break;
+    }
+
+    return record;
+  }
+
+  bool CButtonMapCompiler::Write(const std::string& path)
+  {
+    // Files were added in path order, so the stable sort keeps the first file
+    // of each device in front
+    std::stable_sort(m_devices.begin(), m_devices.end(),
+      [](const CompiledDevice& lhs, const CompiledDevice& rhs)
+      {
+        return lhs.device < rhs.device;
+      });
+
+    // Like CResources::AddResource(), keep the first file for a device. The
+    // lookup's binary search needs unique keys.
+    auto itUnique = std::unique(m_devices.begin(), m_devices.end(),
+      [](const CompiledDevice& first, const CompiledDevice& duplicate)
+      {
+        if (first.device == duplicate.device)
+        {
+          fprintf(stderr, "warning: skipping %s, device is already loaded from %s\n", duplicate.path.c_str(), first.path.c_str());
+          return true;
+        }
+        return false;
+      });
+    m_devices.erase(itUnique, m_devices.end());
+
+    std::vector<BinaryDevice>       devices;
+    std::vector<BinaryController>   controllers;
+    std::vector<BinaryFeature>      features;
+    std::vector<BinaryPrimitive>    primitives;
+    std::vector<BinaryAxisConfig>   axes;
+    std::vector<BinaryButtonConfig> buttons;
+
+    for (const CompiledDevice& compiledDevice : m_devices)
+    {
+      const CDevice& device = compiledDevice.device;
+      const CDeviceConfiguration& config = device.Configuration();
+
+      BinaryDevice deviceRecord{ };
+      deviceRecord.name = Intern(device.Name());
+      deviceRecord.provider = Intern(device.Provider());
+      deviceRecord.vendorId = device.VendorID();
+      deviceRecord.productId = device.ProductID();
+      deviceRecord.buttonCount = static_cast<uint16_t>(device.ButtonCount());
+      deviceRecord.hatCount = static_cast<uint16_t>(device.HatCount());
+      deviceRecord.axisCount = static_cast<uint16_t>(device.AxisCount());
+      deviceRecord.index = device.Index();
+      deviceRecord.controllers = { static_cast<uint32_t>(controllers.size()), static_cast<uint32_t>(compiledDevice.buttonMap.size()) };
+      deviceRecord.axes = { static_cast<uint32_t>(axes.size()), static_cast<uint32_t>(config.Axes().size()) };
+      deviceRecord.buttons = { static_cast<uint32_t>(buttons.size()), static_cast<uint32_t>(config.Buttons().size()) };
+      devices.push_back(deviceRecord);
+
+      for (const auto& axis : config.Axes())
+      {
+        BinaryAxisConfig axisRecord{ };
+        axisRecord.index = axis.first;
+        axisRecord.center = axis.second.trigger.center;
+        axisRecord.range = axis.second.trigger.range;
+        axisRecord.bIgnore = axis.second.bIgnore ? 1 : 0;
+        axes.push_back(axisRecord);
+      }
+
+      for (const auto& button : config.Buttons())
+      {
+        BinaryButtonConfig buttonRecord{ };
+        buttonRecord.index = button.first;
+        buttonRecord.bIgnore = button.second.bIgnore ? 1 : 0;
+        buttons.push_back(buttonRecord);
+      }
+
+      for (const auto& controller : compiledDevice.buttonMap)
+      {
+        BinaryController controllerRecord{ };
+        controllerRecord.id = Intern(controller.first);
+        controllerRecord.features.first = static_cast<uint32_t>(features.size());
+
+        for (const kodi::addon::JoystickFeature& feature : controller.second)
+        {
+          EBinaryFeature layout;
+          std::vector<kodi::addon::DriverPrimitive> featurePrimitives;
+          if (!GetLayout(feature, layout, featurePrimitives))
+          {
+            fprintf(stderr, "warning: %s: skipping feature \"%s\" of unknown type\n", compiledDevice.path.c_str(), feature.Name().c_str());
+            continue;
+          }
+
+          BinaryFeature featureRecord{ };
+          featureRecord.name = Intern(feature.Name());
+          featureRecord.layout = static_cast<uint8_t>(layout);
+          featureRecord.primitives = { static_cast<uint32_t>(primitives.size()), static_cast<uint32_t>(featurePrimitives.size()) };
+          features.push_back(featureRecord);
+
+          for (const kodi::addon::DriverPrimitive& primitive : featurePrimitives)
+            primitives.push_back(Compile(primitive));
+        }
+
+        controllerRecord.features.count = static_cast<uint32_t>(features.size()) - controllerRecord.features.first;
+        controllers.push_back(controllerRecord);
+      }
+    }
+
+    // Pad the string table so the file size stays aligned
+    while (m_strings.size() % BINARY_DATABASE_ALIGNMENT != 0)
+      m_strings.push_back('\0');
+
+    BinaryHeader header{ };
+    header.magic = BINARY_DATABASE_MAGIC;
+    header.version = BINARY_DATABASE_VERSION;
+
+    uint32_t offset = sizeof(BinaryHeader);
+
+    auto place = [&offset](BinaryRange& range, size_t count, size_t recordSize)
+    {
+      range.first = offset;
+      range.count = static_cast<uint32_t>(count);
+      offset += static_cast<uint32_t>(count * recordSize);
+    };
+
+    place(header.devices, devices.size(), sizeof(BinaryDevice));
+    place(header.controllers, controllers.size(), sizeof(BinaryController));
+    place(header.features, features.size(), sizeof(BinaryFeature));
+    place(header.primitives, primitives.size(), sizeof(BinaryPrimitive));
+    place(header.axes, axes.size(), sizeof(BinaryAxisConfig));
+    place(header.buttons, buttons.size(), sizeof(BinaryButtonConfig));
+    place(header.strings, m_strings.size(), 1);
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr)
+    {
+      fprintf(stderr, "Can't create %s\n", path.c_str());
+      return false;
+    }
+
+    bool bSuccess = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    auto write = [file, &bSuccess](const void* data, size_t size)
+    {
+      if (bSuccess && size > 0)
+        bSuccess = fwrite(data, size, 1, file) == 1;
+    };
+
+    write(devices.data(), devices.size() * sizeof(BinaryDevice));
+    write(controllers.data(), controllers.size() * sizeof(BinaryController));
+    write(features.data(), features.size() * sizeof(BinaryFeature));
+    write(primitives.data(), primitives.size() * sizeof(BinaryPrimitive));
+    write(axes.data(), axes.size() * sizeof(BinaryAxisConfig));
+    write(buttons.data(), buttons.size() * sizeof(BinaryButtonConfig));
+    write(m_strings.data(), m_strings.size());
+
+    if (fclose(file) != 0)
+      bSuccess = false;
+
+    if (!bSuccess)
+    {
+      fprintf(stderr, "Failed to write %s\n", path.c_str());
+      remove(path.c_str());
+      return false;
+    }
+
+    printf("Compiled %u button maps into %s (%u bytes)\n", DeviceCount(), path.c_str(), offset);
+
+    return true;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  if (argc != 3)
+  {
+    fprintf(stderr, "Usage: %s <xml folder> <database file>\n", argv[0]);
+    return 2;
+  }
+
+  CButtonMapCompiler compiler;
+  compiler.AddFolder(argv[1], FOLDER_DEPTH);
+
+  if (compiler.RejectedCount() > 0)
+    fprintf(stderr, "Skipped %u invalid button maps\n", compiler.RejectedCount());
+
+  if (compiler.DeviceCount() == 0)
+  {
+    fprintf(stderr, "No button maps found in %s\n", argv[1]);
+    return 1;
+  }
+
+  if (!compiler.Write(argv[2]))
+    return 1;
+
+  return 0;
+}
@@ -0,0 +1,168 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "DatabaseBinary.h"
+#include "ButtonMapBinary.h"
+#include "storage/Device.h"
+#include "storage/StorageDefinitions.h"
+
+#include <string.h>
+
+using namespace JOYSTICK;
+
+namespace
+{
+  template<typename T>
+  int Compare(T lhs, T rhs)
+  {
+    return lhs < rhs ? -1 : (rhs < lhs ? 1 : 0);
+  }
+
+  /*!
+   * \brief Compare a device record to a device in the order of
+   *        CDevice::operator<()
+   */
+  int Compare(const CBinaryDatabaseFile& database, const BinaryDevice& record, const CDevice& device)
+  {
+    int result;
+
+    if ((result = strcmp(database.String(record.name), device.Name().c_str())) != 0)
+      return result;
+
+    if ((result = strcmp(database.String(record.provider), device.Provider().c_str())) != 0)
+      return result;
+
+    if ((result = Compare<unsigned int>(record.vendorId, device.VendorID())) != 0)
+      return result;
+
+    if ((result = Compare<unsigned int>(record.productId, device.ProductID())) != 0)
+      return result;
+
+    if ((result = Compare<unsigned int>(record.buttonCount, device.ButtonCount())) != 0)
+      return result;
+
+    if ((result = Compare<unsigned int>(record.hatCount, device.HatCount())) != 0)
+      return result;
+
+    if ((result = Compare<unsigned int>(record.axisCount, device.AxisCount())) != 0)
+      return result;
+
+    return Compare<unsigned int>(record.index, device.Index());
+  }
+}
+
+CDatabaseBinary::CDatabaseBinary(const std::string& strBasePath, IDatabaseCallbacks* callbacks, IControllerHelper *controllerHelper) :
+  IDatabase(callbacks),
+  m_strPath(strBasePath + "/" RESOURCE_BINARY_DATABASE),
+  m_controllerHelper(controllerHelper)
+{
+}
+
+CDatabaseBinary::~CDatabaseBinary(void)
+{
+  // Resources refer to the mapped records
+  m_resources.clear();
+  m_database.Close();
+}
+
+bool CDatabaseBinary::Open(void)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  m_resources.clear();
+
+  if (!m_database.Open(m_strPath))
+    return false;
+
+  m_resources.resize(m_database.DeviceCount());
+
+  return true;
+}
+
+const ButtonMap& CDatabaseBinary::GetButtonMap(const kodi::addon::Joystick& driverInfo)
+{
+  static ButtonMap empty;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  CButtonMapBinary* resource = GetResource(CDevice(driverInfo));
+
+  if (resource)
+    return resource->GetButtonMap();
+
+  return empty;
+}
+
+bool CDatabaseBinary::GetIgnoredPrimitives(const kodi::addon::Joystick& driverInfo, PrimitiveVector& primitives)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  CButtonMapBinary* resource = GetResource(CDevice(driverInfo));
+
+  if (resource)
+  {
+    primitives = resource->Device()->Configuration().GetIgnoredPrimitives();
+    return true;
+  }
+
+  return false;
+}
+
+void CDatabaseBinary::ReportButtonMaps(void)
+{
+  // Lock per device so that lookups aren't held up
+  for (unsigned int deviceIndex = 0; deviceIndex < m_database.DeviceCount(); deviceIndex++)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    GetResource(deviceIndex);
+  }
+}
+
+CButtonMapBinary* CDatabaseBinary::GetResource(const CDevice& deviceInfo)
+{
+  // Binary search of the sorted device index
+  unsigned int first = 0;
+  unsigned int last = m_database.DeviceCount();
+
+  while (first < last)
+  {
+    const unsigned int middle = first + (last - first) / 2;
+
+    const int result = Compare(m_database, m_database.Device(middle), deviceInfo);
+    if (result == 0)
+      return GetResource(middle);
+
+    if (result < 0)
+      first = middle + 1;
+    else
+      last = middle;
+  }
+
+  return nullptr;
+}
+
+CButtonMapBinary* CDatabaseBinary::GetResource(unsigned int deviceIndex)
+{
+  std::unique_ptr<CButtonMapBinary>& resource = m_resources[deviceIndex];
+
+  if (!resource)
+  {
+    resource.reset(new CButtonMapBinary(m_database, m_database.Device(deviceIndex), m_controllerHelper));
+
+    // Load device info and button map
+    if (!resource->IsValid() || !resource->Refresh())
+    {
+      resource.reset();
+      return nullptr;
+    }
+
+    m_callbacks->OnAdd(resource->Device(), resource->GetButtonMap());
+  }
+
+  return resource.get();
+}
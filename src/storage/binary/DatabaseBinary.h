@@ -0,0 +1,71 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "BinaryDatabaseFile.h"
+#include "storage/IDatabase.h"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace JOYSTICK
+{
+  class CButtonMapBinary;
+  class IControllerHelper;
+
+  /*!
+   * \brief Read-only database of the button maps compiled at build time
+   *
+   * The database file is mapped into memory, and devices are found with a
+   * binary search over its sorted device index. A device's button map is
+   * read from the mapped records when the device is first looked up.
+   */
+  class CDatabaseBinary : public IDatabase
+  {
+  public:
+    CDatabaseBinary(const std::string& strBasePath, IDatabaseCallbacks* callbacks, IControllerHelper *controllerHelper);
+
+    virtual ~CDatabaseBinary(void);
+
+    /*!
+     * \brief Map the database file into memory
+     *
+     * \return False if the file doesn't exist or is invalid, true otherwise
+     */
+    bool Open(void);
+
+    // implementation of IDatabase
+    virtual const ButtonMap& GetButtonMap(const kodi::addon::Joystick& driverInfo) override;
+    virtual bool MapFeatures(const kodi::addon::Joystick& driverInfo, const std::string& controllerId, const FeatureVector& features) override { return false; }
+    virtual bool GetIgnoredPrimitives(const kodi::addon::Joystick& driverInfo, PrimitiveVector& primitives) override;
+    virtual bool SetIgnoredPrimitives(const kodi::addon::Joystick& driverInfo, const PrimitiveVector& primitives) override { return false; }
+    virtual bool SaveButtonMap(const kodi::addon::Joystick& driverInfo) override { return false; }
+    virtual bool RevertButtonMap(const kodi::addon::Joystick& driverInfo) override { return false; }
+    virtual bool ResetButtonMap(const kodi::addon::Joystick& driverInfo, const std::string& controllerId) override { return false; }
+    virtual void ReportButtonMaps(void) override;
+
+  private:
+    /*!
+     * \brief Get the resource of a device, or nullptr if the device isn't in
+     *        the database
+     */
+    CButtonMapBinary* GetResource(const CDevice& deviceInfo);
+    CButtonMapBinary* GetResource(unsigned int deviceIndex);
+
+    // Construction parameters
+    const std::string        m_strPath;
+    IControllerHelper *const m_controllerHelper;
+
+    CBinaryDatabaseFile m_database;
+    std::vector<std::unique_ptr<CButtonMapBinary>> m_resources; // By device index, created when needed
+    std::mutex          m_mutex;
+  };
+}
@@ -12,17 +12,6 @@
 
 #include <string>
 
-class TiXmlElement;
-
-namespace kodi
-{
-namespace addon
-{
-  struct DriverPrimitive;
-  class JoystickFeature;
-}
-}
-
 namespace JOYSTICK
 {
   class CAnomalousTrigger;
@@ -37,21 +26,21 @@ namespace JOYSTICK
 
     virtual ~CButtonMapXml(void) { }
 
+    // implementation of CButtonMap
+    virtual bool LoadDevice(void) override;
+
   protected:
     // implementation of CButtonMap
     virtual bool Load(void) override;
     virtual bool Save(void) const override;
 
   private:
-    bool SerializeButtonMaps(TiXmlElement* pElement) const;
-
-    bool Serialize(const FeatureVector& features, TiXmlElement* pElement) const;
-    bool Deserialize(const TiXmlElement* pElement, FeatureVector& features, const std::string &controllerId) const;
+    /*!
+     * \brief Read the <device> start tag from the beginning of a file,
+     *        without reading the controller profiles that follow
+     */
+    static bool ReadDeviceElement(const std::string& path, std::string& element);
 
-    static bool IsValid(const kodi::addon::JoystickFeature& feature);
-    static bool SerializeFeature(TiXmlElement* pElement, const kodi::addon::DriverPrimitive& primitive, const char* tagName);
-    static bool SerializePrimitiveTag(TiXmlElement* pElement, const kodi::addon::DriverPrimitive& primitive, const char* tagName);
-    static void SerializePrimitive(TiXmlElement* pElement, const kodi::addon::DriverPrimitive& primitive);
-    static bool DeserializePrimitive(const TiXmlElement* pElement, kodi::addon::DriverPrimitive& primitive);
+    bool m_bDeviceIndexed = false; // Device was read without its configuration
   };
 }
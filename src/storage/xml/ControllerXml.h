@@ -0,0 +1,51 @@
+/*
+ *  Copyright (C) 2015-2020 Garrett Brown
+ *  Copyright (C) 2015-2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "buttonmapper/ButtonMapTypes.h"
+
+#include <string>
+
+class TiXmlElement;
+
+namespace kodi
+{
+namespace addon
+{
+  struct DriverPrimitive;
+  class JoystickFeature;
+}
+}
+
+namespace JOYSTICK
+{
+  class IControllerHelper;
+
+  /*!
+   * \brief Reads and writes the <controller> elements of a button map
+   *
+   * The types of directional features depend on the controller profile, and
+   * are looked up through the controller helper when deserializing.
+   */
+  class CControllerXml
+  {
+  public:
+    static bool SerializeButtonMap(const ButtonMap& buttonMap, TiXmlElement* pElement);
+    static bool DeserializeButtonMap(const TiXmlElement* pElement, ButtonMap& buttonMap, IControllerHelper* controllerHelper);
+
+    static bool Serialize(const FeatureVector& features, TiXmlElement* pElement);
+    static bool Deserialize(const TiXmlElement* pElement, FeatureVector& features, const std::string& controllerId, IControllerHelper* controllerHelper);
+
+  private:
+    static bool IsValid(const kodi::addon::JoystickFeature& feature);
+    static bool SerializePrimitiveTag(TiXmlElement* pElement, const kodi::addon::DriverPrimitive& primitive, const char* tagName);
+    static void SerializePrimitive(TiXmlElement* pElement, const kodi::addon::DriverPrimitive& primitive);
+    static bool DeserializePrimitive(const TiXmlElement* pElement, kodi::addon::DriverPrimitive& primitive);
+  };
+}
@@ -0,0 +1,52 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "LatencyHistogram.h"
+
+#include <stdint.h>
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Converts a driver's event timestamps to GetMonotonicTimeUs()
+   *
+   * The offset between the clocks is estimated from events as they're read.
+   * An event is read after it's generated, so the smallest difference seen
+   * between the read time and the event time is the closest estimate. A
+   * difference that grows by more than MAX_DELAY_US means the driver clock
+   * wrapped or jumped, and the estimate starts over.
+   */
+  class CClockOffset
+  {
+  public:
+    static const int64_t MAX_DELAY_US = 1000000;
+
+    /*!
+     * \brief Update the estimate with the timestamp of an event that was
+     *        just read
+     */
+    void Update(int64_t driverTimeUs)
+    {
+      const int64_t offsetUs = GetMonotonicTimeUs() - driverTimeUs;
+
+      if (!m_bValid || offsetUs < m_offsetUs || offsetUs > m_offsetUs + MAX_DELAY_US)
+      {
+        m_offsetUs = offsetUs;
+        m_bValid = true;
+      }
+    }
+
+    int64_t ToMonotonic(int64_t driverTimeUs) const { return driverTimeUs + m_offsetUs; }
+
+  private:
+    int64_t m_offsetUs = 0;
+    bool    m_bValid = false;
+  };
+}
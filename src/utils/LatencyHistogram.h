@@ -0,0 +1,120 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+#include <string>
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Get the time in microseconds from the monotonic clock
+   *
+   * On Linux this is CLOCK_MONOTONIC, the clock used for evdev timestamps
+   * after EVIOCSCLOCKID.
+   */
+  inline int64_t GetMonotonicTimeUs(void)
+  {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  /*!
+   * \brief Histogram of latencies with power-of-two buckets
+   *
+   * Bucket 0 counts latencies below 1us, and bucket i counts latencies in
+   * [2^(i-1), 2^i) us. Recording is a few shifts and a relaxed atomic
+   * increment, so it's cheap enough for the input path. One thread records
+   * while another reads and resets.
+   */
+  class CLatencyHistogram
+  {
+  public:
+    static const unsigned int BUCKET_COUNT = 24; // Last bucket counts everything above ~4s
+
+    CLatencyHistogram(void) { Reset(); }
+
+    void Record(int64_t latencyUs)
+    {
+      unsigned int bucket = 0;
+      while (latencyUs > 0 && bucket < BUCKET_COUNT - 1)
+      {
+        latencyUs >>= 1;
+        bucket++;
+      }
+
+      m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Reset(void)
+    {
+      for (auto& bucket : m_buckets)
+        bucket.store(0, std::memory_order_relaxed);
+    }
+
+    unsigned int Count(void) const
+    {
+      unsigned int count = 0;
+      for (const auto& bucket : m_buckets)
+        count += bucket.load(std::memory_order_relaxed);
+      return count;
+    }
+
+    /*!
+     * \brief Get the upper bound of the bucket containing the given percentile
+     *
+     * \param percentile The percentile, in the range [0, 100]
+     *
+     * \return The upper bound in microseconds, or 0 if nothing was recorded
+     */
+    int64_t Percentile(float percentile) const
+    {
+      std::array<uint32_t, BUCKET_COUNT> buckets;
+      uint64_t total = 0;
+
+      for (unsigned int i = 0; i < BUCKET_COUNT; i++)
+      {
+        buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+        total += buckets[i];
+      }
+
+      if (total == 0)
+        return 0;
+
+      const uint64_t rank = static_cast<uint64_t>(total * percentile / 100.0f);
+
+      uint64_t count = 0;
+      for (unsigned int i = 0; i < BUCKET_COUNT; i++)
+      {
+        count += buckets[i];
+        if (count > rank || i == BUCKET_COUNT - 1)
+          return static_cast<int64_t>(1) << i;
+      }
+
+      return 0;
+    }
+
+    /*!
+     * \brief Summarize the histogram for a log line
+     */
+    std::string ToString(void) const
+    {
+      return "n=" + std::to_string(Count()) +
+             " p50<" + std::to_string(Percentile(50.0f)) + "us" +
+             " p90<" + std::to_string(Percentile(90.0f)) + "us" +
+             " p99<" + std::to_string(Percentile(99.0f)) + "us";
+    }
+
+  private:
+    std::array<std::atomic<uint32_t>, BUCKET_COUNT> m_buckets;
+  };
+}
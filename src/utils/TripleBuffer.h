@@ -0,0 +1,94 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Wait-free exchange of snapshots between one producer and one consumer
+   *
+   * The producer fills Back() and calls Publish(). The consumer calls Acquire()
+   * and reads Front(). Neither side ever blocks or waits for the other, and the
+   * consumer always sees the most recently published snapshot.
+   */
+  template<typename T>
+  class CTripleBuffer
+  {
+  public:
+    /*!
+     * \brief Assign a value to all buffers. Not thread-safe.
+     */
+    void Reset(const T& value)
+    {
+      for (T& buffer : m_buffers)
+        buffer = value;
+
+      m_back = 0;
+      m_middle = 1;
+      m_front = 2;
+    }
+
+    /*!
+     * \brief Buffer owned by the producer
+     */
+    T& Back(void) { return m_buffers[m_back]; }
+
+    /*!
+     * \brief Make the producer's buffer available to the consumer
+     */
+    void Publish(void)
+    {
+      m_back = m_middle.exchange(m_back | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    /*!
+     * \brief Check if the most recently published buffer hasn't been acquired
+     *        by the consumer yet
+     *
+     * The result may be stale by the time it is used, but it can only change
+     * from true to false while the producer isn't publishing.
+     */
+    bool IsPending(void) const
+    {
+      return (m_middle.load(std::memory_order_relaxed) & FRESH_BIT) != 0;
+    }
+
+    /*!
+     * \brief Take ownership of the most recently published buffer
+     *
+     * \return true if a new buffer was published since the last call
+     */
+    bool Acquire(void)
+    {
+      if ((m_middle.load(std::memory_order_relaxed) & FRESH_BIT) == 0)
+        return false;
+
+      m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX_MASK;
+
+      return true;
+    }
+
+    /*!
+     * \brief Buffer owned by the consumer
+     */
+    const T& Front(void) const { return m_buffers[m_front]; }
+
+  private:
+    static const unsigned int INDEX_MASK = 0x3;
+    static const unsigned int FRESH_BIT  = 0x4;
+
+    std::array<T, 3>          m_buffers;
+    unsigned int              m_back = 0;
+    std::atomic<unsigned int> m_middle{1};
+    unsigned int              m_front = 2;
+  };
+}
@@ -0,0 +1,82 @@
+/*
+ *  Copyright (C) 2020 Garrett Brown
+ *  Copyright (C) 2020 Team Kodi
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <stddef.h>
+#include <thread>
+#include <vector>
+
+namespace JOYSTICK
+{
+  /*!
+   * \brief Run independent jobs on a bounded number of threads
+   *
+   * Threads are started for each batch of jobs and joined when the batch is
+   * done. The calling thread runs jobs too, so at most WorkerCount() - 1
+   * threads are started.
+   */
+  class CWorkerPool
+  {
+  public:
+    explicit CWorkerPool(unsigned int workerCount) :
+      m_workerCount(std::max(workerCount, 1u))
+    {
+    }
+
+    /*!
+     * \brief Get the number of hardware threads, limited to the specified
+     *        maximum
+     */
+    static unsigned int HardwareWorkerCount(unsigned int maxWorkers)
+    {
+      const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+
+      return std::max(std::min(hardwareThreads, maxWorkers), 1u);
+    }
+
+    unsigned int WorkerCount(void) const { return m_workerCount; }
+
+    /*!
+     * \brief Call a function for each index in [0, count) and wait for all
+     *        calls to return
+     *
+     * Calls may run concurrently and in any order.
+     */
+    template<typename FUNC>
+    void ForEach(size_t count, const FUNC& func) const
+    {
+      std::atomic<size_t> next{0};
+
+      auto worker = [count, &func, &next]()
+      {
+        size_t index;
+        while ((index = next.fetch_add(1, std::memory_order_relaxed)) < count)
+          func(index);
+      };
+
+      const size_t threadCount = std::min(static_cast<size_t>(m_workerCount), count);
+
+      std::vector<std::thread> threads;
+      threads.reserve(threadCount);
+
+      for (size_t i = 1; i < threadCount; i++)
+        threads.emplace_back(worker);
+
+      worker();
+
+      for (std::thread& thread : threads)
+        thread.join();
+    }
+
+  private:
+    const unsigned int m_workerCount;
+  };
+}